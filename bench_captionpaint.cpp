@@ -0,0 +1,213 @@
+/*!
+ * Caption paint throughput benchmark.
+ *
+ * Renders a fully populated CaptionWidget into a QImage with the offscreen 
+ * QPA plugin for every combination of device pixel ratio and style sheet 
+ * below, and reports paints per second and heap allocations per paint:
+ *
+ *   ./xframelesswidget_bench_captionpaint --duration 2000 --output paint.json
+ *
+ * Allocations are counted by interposing malloc on glibc, which also sees 
+ * Qt's own containers; elsewhere only operator new in this executable is 
+ * counted.
+ */
+#include "QtCore/QCommandLineParser"
+#include "QtCore/QElapsedTimer"
+#include "QtCore/QFile"
+#include "QtCore/QJsonArray"
+#include "QtCore/QJsonDocument"
+#include "QtCore/QJsonObject"
+#include "QtGui/QImage"
+#include "QtGui/QPainter"
+#include "QtWidgets/QApplication"
+#include "QtWidgets/QLineEdit"
+#include "QtWidgets/QToolButton"
+
+#include "captionwidget.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+	std::atomic<quint64> g_allocations(0);
+}
+
+#if defined(__GLIBC__)
+extern "C"
+{
+	void *__libc_malloc(size_t size);
+	void *__libc_calloc(size_t count, size_t size);
+	void *__libc_realloc(void *ptr, size_t size);
+
+	// operator new ends up here too, so it is not replaced as well;
+	void *malloc(size_t size)
+	{
+		g_allocations.fetch_add(1, std::memory_order_relaxed);
+		return __libc_malloc(size);
+	}
+
+	void *calloc(size_t count, size_t size)
+	{
+		g_allocations.fetch_add(1, std::memory_order_relaxed);
+		return __libc_calloc(count, size);
+	}
+
+	void *realloc(void *ptr, size_t size)
+	{
+		g_allocations.fetch_add(1, std::memory_order_relaxed);
+		return __libc_realloc(ptr, size);
+	}
+}
+#else
+void *operator new(size_t size)
+{
+	g_allocations.fetch_add(1, std::memory_order_relaxed);
+	if (void *ptr = std::malloc(size ? size : 1))
+	{
+		return ptr;
+	}
+	throw std::bad_alloc();
+}
+
+void operator delete(void *ptr) noexcept
+{
+	std::free(ptr);
+}
+#endif
+
+namespace
+{
+	struct StyleConfig
+	{
+		const char *name;
+		const char *styleSheet;
+	};
+
+	const StyleConfig kStyles[] = {
+		{ "none", "" },
+		{ "flat",
+		  "CaptionWidget { background: #2b2b2b; }"
+		  "QLabel { color: #e0e0e0; }"
+		  "QPushButton { border: none; background: transparent; color: #e0e0e0; }" },
+		{ "rich",
+		  "CaptionWidget { background: qlineargradient(x1:0, y1:0, x2:0, y2:1, stop:0 #3c3f41, stop:1 #2b2b2b);"
+		  " border-bottom: 1px solid #1e1e1e; }"
+		  "QLabel#titleLbl { color: #f0f0f0; font: bold 12px; padding-left: 4px; }"
+		  "QPushButton { border: 1px solid transparent; border-radius: 4px; margin: 2px;"
+		  " background: qradialgradient(cx:0.5, cy:0.5, radius:0.8, fx:0.5, fy:0.5, stop:0 #4a4d50, stop:1 #3c3f41); }"
+		  "QPushButton:hover { border-color: #6a6d70; }"
+		  "QPushButton#btnClose:hover { background: #c42b1c; }"
+		  "QLineEdit { border: 1px solid #555; border-radius: 8px; padding: 0 6px; background: #1e1e1e; color: #ddd; }"
+		  "QToolButton { border: none; color: #9cdcfe; }" },
+	};
+
+	const qreal kDevicePixelRatios[] = { 1.0, 1.25, 1.5, 2.0 };
+
+	constexpr int kWarmupPaints = 20;
+
+	CaptionWidget *createCaption()
+	{
+		CaptionWidget *caption = new CaptionWidget;
+		QPixmap icon(16, 16);
+		icon.fill(QColor(0x3d, 0x8e, 0xe8));
+		caption->setIcon(icon);
+		caption->setTitleText("XFramelessWidget caption paint benchmark");
+
+		QLineEdit *search = new QLineEdit;
+		search->setPlaceholderText("Search");
+		search->setFixedWidth(160);
+		caption->insertWidget(caption->indexOfMoreButton(), search);
+		QToolButton *account = new QToolButton;
+		account->setText("Account");
+		caption->insertWidget(caption->indexOfMoreButton(), account);
+
+		caption->resize(800, caption->sizeHint().height());
+		caption->show();
+		return caption;
+	}
+
+	QJsonObject measure(CaptionWidget *caption, const StyleConfig &style, qreal dpr, qint64 durationMs)
+	{
+		caption->setStyleSheet(QString::fromLatin1(style.styleSheet));
+		caption->ensurePolished();
+
+		QImage image(caption->size() * dpr, QImage::Format_ARGB32_Premultiplied);
+		image.setDevicePixelRatio(dpr);
+		for (int i = 0; i < kWarmupPaints; ++i)
+		{
+			caption->render(&image);
+		}
+
+		qint64 paints = 0;
+		const quint64 allocations = g_allocations.load(std::memory_order_relaxed);
+		QElapsedTimer timer;
+		timer.start();
+		do
+		{
+			caption->render(&image);
+			++paints;
+		} while (timer.elapsed() < durationMs);
+		const qint64 elapsedNs = timer.nsecsElapsed();
+		const quint64 allocated = g_allocations.load(std::memory_order_relaxed) - allocations;
+
+		QJsonObject obj;
+		obj.insert("style", style.name);
+		obj.insert("dpr", dpr);
+		obj.insert("paints", paints);
+		obj.insert("paints_per_second", paints * 1e9 / elapsedNs);
+		obj.insert("allocations_per_paint", static_cast<double>(allocated) / paints);
+		return obj;
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+	{
+		qputenv("QT_QPA_PLATFORM", "offscreen");
+	}
+	QApplication a(argc, argv);
+
+	QCommandLineParser parser;
+	parser.addHelpOption();
+	parser.addOption({ "duration", "Measuring time per configuration.", "ms", "1000" });
+	parser.addOption({ "output", "Write the JSON report to file.", "file" });
+	parser.process(a);
+	const qint64 durationMs = qMax(1, parser.value("duration").toInt());
+
+	QScopedPointer<CaptionWidget> caption(createCaption());
+	QJsonArray results;
+	for (const StyleConfig &style : kStyles)
+	{
+		for (const qreal dpr : kDevicePixelRatios)
+		{
+			results.append(measure(caption.data(), style, dpr, durationMs));
+		}
+	}
+
+	QJsonObject root;
+	root.insert("benchmark", "captionpaint");
+	root.insert("platform", QGuiApplication::platformName());
+	root.insert("duration_ms", durationMs);
+	root.insert("results", results);
+	const QByteArray json = QJsonDocument(root).toJson();
+
+	if (parser.isSet("output"))
+	{
+		QFile file(parser.value("output"));
+		if (!file.open(QFile::WriteOnly))
+		{
+			qCritical("cannot write %s", qPrintable(file.fileName()));
+			return 1;
+		}
+		file.write(json);
+	}
+	else
+	{
+		fwrite(json.constData(), 1, json.size(), stdout);
+	}
+	return 0;
+}
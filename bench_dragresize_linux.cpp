@@ -0,0 +1,400 @@
+/*!
+ * Drag and resize latency benchmark (X11 only).
+ *
+ * Injects press/motion/release sequences with XTest on the caption and on
+ * every resize edge of an XFramelessWidgetWithCaption and measures, on a
+ * separate X connection, the time from each injected motion to the window's
+ * ConfigureNotify, and the time from hovering an edge to the cursor change
+ * (XFixes cursor notify). Needs a running window manager, e.g.:
+ *
+ *   Xvfb :99 -screen 0 1920x1080x24 &
+ *   DISPLAY=:99 openbox &
+ *   DISPLAY=:99 ./xframelesswidget_bench_dragresize --samples 200
+ *
+ * Percentiles are written as JSON to stdout or to --output.
+ */
+#include "QtCore/QCommandLineParser"
+#include "QtCore/QFile"
+#include "QtCore/QJsonDocument"
+#include "QtCore/QJsonObject"
+#include "QtCore/QTimer"
+#include "QtGui/QGuiApplication"
+#include "QtWidgets/QApplication"
+#include "QtWidgets/QLabel"
+
+#include "xframelesswidget.h"
+
+#include <X11/Xlib.h>
+#include <X11/extensions/XTest.h>
+#include <X11/extensions/Xfixes.h>
+#include <poll.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	typedef std::chrono::steady_clock Clock;
+
+	// layout margins of the benchmarked window and the resize handle width
+	// used by XFramelessWidget on Linux;
+	constexpr int kMargin = 10;
+	constexpr int kHandle = 10;
+	constexpr int kStep = 4;
+	constexpr int kTimeoutMs = 500;
+	constexpr int kSettleMs = 100;
+
+	struct Target
+	{
+		const char *name;
+		// pointer position as fractions of the window size plus a pixel offset;
+		double fx, fy;
+		int ox, oy;
+		// direction of a positive step;
+		int dx, dy;
+	};
+
+	const Target kEdges[] = {
+		{ "resize_top", 0.5, 0.0, 0, kMargin - kHandle / 2, 0, -1 },
+		{ "resize_right", 1.0, 0.5, -(kMargin - kHandle / 2), 0, 1, 0 },
+		{ "resize_bottom", 0.5, 1.0, 0, -(kMargin - kHandle / 2), 0, 1 },
+		{ "resize_left", 0.0, 0.5, kMargin - kHandle / 2, 0, -1, 0 },
+		{ "resize_top_left", 0.0, 0.0, kMargin - kHandle / 2, kMargin - kHandle / 2, -1, -1 },
+		{ "resize_top_right", 1.0, 0.0, -(kMargin - kHandle / 2), kMargin - kHandle / 2, 1, -1 },
+		{ "resize_bottom_right", 1.0, 1.0, -(kMargin - kHandle / 2), -(kMargin - kHandle / 2), 1, 1 },
+		{ "resize_bottom_left", 0.0, 1.0, kMargin - kHandle / 2, -(kMargin - kHandle / 2), -1, 1 },
+	};
+
+	struct Series
+	{
+		std::vector<double> samples;
+		int dropped = 0;
+	};
+
+	double percentile(std::vector<double> sorted, double p)
+	{
+		if (sorted.empty())
+		{
+			return 0.0;
+		}
+		std::sort(sorted.begin(), sorted.end());
+		// nearest rank;
+		const size_t rank = static_cast<size_t>(std::ceil(p / 100.0 * sorted.size()));
+		return sorted[std::min(sorted.size(), std::max<size_t>(rank, 1)) - 1];
+	}
+
+	QJsonObject toJson(const Series &series)
+	{
+		QJsonObject obj;
+		obj.insert("count", static_cast<int>(series.samples.size()));
+		obj.insert("dropped", series.dropped);
+		obj.insert("p50_ms", percentile(series.samples, 50));
+		obj.insert("p95_ms", percentile(series.samples, 95));
+		obj.insert("p99_ms", percentile(series.samples, 99));
+		return obj;
+	}
+
+	/*!
+	 * Runs on its own thread with its own connection, so waiting for events
+	 * never stalls the Qt event loop of the window under test.
+	 */
+	class Injector final
+	{
+	public:
+		Injector(Display *display, Window window, const QPoint &captionPos, int samples)
+			: _display(display)
+			, _window(window)
+			, _captionPos(captionPos)
+			, _samples(samples)
+		{
+			XFixesQueryExtension(_display, &_fixesEvent, &_fixesError);
+			XSelectInput(_display, _window, StructureNotifyMask);
+			XFixesSelectCursorInput(_display, DefaultRootWindow(_display),
+				XFixesDisplayCursorNotifyMask);
+			XSync(_display, False);
+		}
+
+		QJsonObject run()
+		{
+			QJsonObject results;
+
+			Series move;
+			for (int i = 0; i < _samples; i += kSamplesPerDrag)
+			{
+				drag(_captionPos, 1, 1, move);
+			}
+			results.insert("move", toJson(move));
+
+			Series cursor;
+			for (const Target &target : kEdges)
+			{
+				Series resize;
+				for (int i = 0; i < _samples; i += kSamplesPerDrag)
+				{
+					const QRect geometry = windowGeometry();
+					const QPoint pos(qRound(geometry.width() * target.fx) + target.ox,
+						qRound(geometry.height() * target.fy) + target.oy);
+					hover(pos, cursor);
+					drag(pos, target.dx, target.dy, resize);
+				}
+				results.insert(target.name, toJson(resize));
+			}
+			results.insert("cursor", toJson(cursor));
+			return results;
+		}
+
+	private:
+		static constexpr int kSamplesPerDrag = 20;
+
+		Display *_display;
+		Window _window;
+		QPoint _captionPos;
+		int _samples;
+		int _fixesEvent = 0;
+		int _fixesError = 0;
+
+		QRect windowGeometry()
+		{
+			Window root = 0;
+			Window child = 0;
+			int x = 0;
+			int y = 0;
+			unsigned int width = 0;
+			unsigned int height = 0;
+			unsigned int border = 0;
+			unsigned int depth = 0;
+			XGetGeometry(_display, _window, &root, &x, &y, &width, &height, &border, &depth);
+			XTranslateCoordinates(_display, _window, root, 0, 0, &x, &y, &child);
+			return QRect(x, y, static_cast<int>(width), static_cast<int>(height));
+		}
+
+		bool isReparented()
+		{
+			Window root = 0;
+			Window parent = 0;
+			Window *children = Q_NULLPTR;
+			unsigned int count = 0;
+			if (!XQueryTree(_display, _window, &root, &parent, &children, &count))
+			{
+				return false;
+			}
+			if (children)
+			{
+				XFree(children);
+			}
+			return parent != root;
+		}
+
+		void motion(const QPoint &rootPos)
+		{
+			XTestFakeMotionEvent(_display, -1, rootPos.x(), rootPos.y(), CurrentTime);
+			XFlush(_display);
+		}
+
+		void button(bool press)
+		{
+			XTestFakeButtonEvent(_display, 1, press ? True : False, CurrentTime);
+			XFlush(_display);
+		}
+
+		// waits for an event accepted by pred, returns the latency in ms or -1;
+		template <typename Pred>
+		double wait(const Clock::time_point &start, int timeoutMs, Pred pred)
+		{
+			const Clock::time_point deadline = start + std::chrono::milliseconds(timeoutMs);
+			for (;;)
+			{
+				while (XPending(_display))
+				{
+					XEvent ev;
+					XNextEvent(_display, &ev);
+					if (pred(ev))
+					{
+						return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+					}
+				}
+
+				const auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+					deadline - Clock::now()).count();
+				if (left <= 0)
+				{
+					return -1.0;
+				}
+				pollfd fd = { ConnectionNumber(_display), POLLIN, 0 };
+				poll(&fd, 1, static_cast<int>(left));
+			}
+		}
+
+		void settle()
+		{
+			wait(Clock::now(), kSettleMs, [](const XEvent &) { return false; });
+		}
+
+		/*!
+		 * Moves the pointer from the middle of the window onto pos and
+		 * records how long the server takes to switch the cursor.
+		 */
+		void hover(const QPoint &pos, Series &series)
+		{
+			const QRect geometry = windowGeometry();
+			motion(geometry.center());
+			settle();
+
+			const Clock::time_point start = Clock::now();
+			motion(geometry.topLeft() + pos);
+			const double ms = wait(start, kTimeoutMs, [this](const XEvent &ev) {
+				return ev.type == _fixesEvent + XFixesCursorNotify;
+			});
+			if (ms < 0)
+			{
+				++series.dropped;
+			}
+			else
+			{
+				series.samples.push_back(ms);
+			}
+		}
+
+		/*!
+		 * Presses on the window relative point at, then steps the pointer out by
+		 * (dx, dy) and back again so the window ends where it started. Each
+		 * step is timed until a ConfigureNotify with a new geometry arrives.
+		 */
+		void drag(const QPoint &at, int dx, int dy, Series &series)
+		{
+			QRect last = windowGeometry();
+			const bool reparented = isReparented();
+			QPoint pointer = last.topLeft() + at;
+			motion(pointer);
+			settle();
+			button(true);
+			settle();
+
+			for (int i = 0; i < kSamplesPerDrag; ++i)
+			{
+				const int sign = i < kSamplesPerDrag / 2 ? 1 : -1;
+				pointer += QPoint(dx, dy) * (kStep * sign);
+
+				const Clock::time_point start = Clock::now();
+				motion(pointer);
+				const double ms = wait(start, kTimeoutMs, [this, &last, reparented](const XEvent &ev) {
+					if (ev.type != ConfigureNotify || ev.xconfigure.window != _window)
+					{
+						return false;
+					}
+					// no round trip while timing: the size is in the event, the
+					// position is root relative in the WM's synthetic notify
+					// only, a reparented window's own one is frame relative;
+					const XConfigureEvent &ce = ev.xconfigure;
+					QRect geometry(last.topLeft(), QSize(ce.width, ce.height));
+					if (ce.send_event || !reparented)
+					{
+						geometry.moveTopLeft(QPoint(ce.x, ce.y));
+					}
+					const bool changed = geometry != last;
+					last = geometry;
+					return changed;
+				});
+				if (ms < 0)
+				{
+					++series.dropped;
+				}
+				else
+				{
+					series.samples.push_back(ms);
+				}
+			}
+
+			button(false);
+			settle();
+		}
+	};
+}
+
+int main(int argc, char *argv[])
+{
+	QApplication a(argc, argv);
+
+	QCommandLineParser parser;
+	parser.addHelpOption();
+	parser.addOption({ "samples", "Motion samples per target.", "count", "100" });
+	parser.addOption({ "output", "Write the JSON report to file.", "file" });
+	parser.process(a);
+
+	if (QGuiApplication::platformName() != QLatin1String("xcb"))
+	{
+		qCritical("the drag/resize benchmark needs the xcb platform plugin");
+		return 1;
+	}
+
+	Display *display = XOpenDisplay(Q_NULLPTR);
+	int event = 0;
+	int error = 0;
+	int major = 0;
+	int minor = 0;
+	if (!display
+		|| !XTestQueryExtension(display, &event, &error, &major, &minor)
+		|| !XFixesQueryExtension(display, &event, &error))
+	{
+		qCritical("XTest and XFixes are required");
+		return 1;
+	}
+
+	XFramelessWidgetWithCaption w;
+	w.setContentWidget(new QLabel("drag and resize benchmark"));
+	w.setMainLayoutMargins(kMargin, kMargin, kMargin, kMargin);
+	w.setWindowTitle("bench_dragresize");
+	w.resize(640, 480);
+	w.showCenter();
+
+	QJsonObject report;
+	std::thread injector;
+	QTimer::singleShot(500, &w, [&]() {
+		QWidget *caption = w.captionItf()->widget();
+		const QPoint captionPos = caption->mapTo(&w, QPoint(caption->width() / 3, caption->height() / 2));
+		const Window window = static_cast<Window>(w.winId());
+		const int samples = qMax(1, parser.value("samples").toInt());
+		injector = std::thread([&report, display, window, captionPos, samples]() {
+			Injector bench(display, window, captionPos, samples);
+			report = bench.run();
+			QMetaObject::invokeMethod(qApp, "quit", Qt::QueuedConnection);
+		});
+	});
+
+	const int ret = a.exec();
+	if (injector.joinable())
+	{
+		injector.join();
+	}
+	XCloseDisplay(display);
+	if (ret != 0)
+	{
+		return ret;
+	}
+
+	QJsonObject root;
+	root.insert("benchmark", "dragresize");
+	root.insert("samples_per_target", parser.value("samples").toInt());
+	root.insert("results", report);
+	const QByteArray json = QJsonDocument(root).toJson();
+
+	if (parser.isSet("output"))
+	{
+		QFile file(parser.value("output"));
+		if (!file.open(QFile::WriteOnly))
+		{
+			qCritical("cannot write %s", qPrintable(file.fileName()));
+			return 1;
+		}
+		file.write(json);
+	}
+	else
+	{
+		fwrite(json.constData(), 1, json.size(), stdout);
+	}
+	return 0;
+}
@@ -0,0 +1,660 @@
+/*!
+ * X protocol cost regression check (X11 only).
+ *
+ * Starts a counting proxy in front of a local X server, points the Qt
+ * connection (and every other connection the library opens) at it, then
+ * runs a fixed list of operations on an XFramelessWidgetWithCaption and
+ * counts, per operation, the requests sent, the replies received, i.e. the
+ * round trips the client waited for, and the writes the client made, i.e.
+ * its flushes. The counts are compared with a budget file and the process
+ * exits with 1 if any of them is exceeded:
+ *
+ *   Xvfb :99 -screen 0 1920x1080x24 &
+ *   DISPLAY=:99 openbox &
+ *   DISPLAY=:99 ./xframelesswidget_bench_xrequests --budget bench_xrequests_budget.json
+ *
+ * --update-budget rewrites the budget file from the measured counts and
+ * records the setup they were measured on: Qt, the X server, the screen
+ * and the window manager. A check on another setup warns. The
+ * X server must accept connections without authorization (Xvfb does
+ * unless started with -auth), since the proxy's display has no cookie.
+ */
+#include "QtCore/QCommandLineParser"
+#include "QtCore/QElapsedTimer"
+#include "QtCore/QFile"
+#include "QtCore/QJsonDocument"
+#include "QtCore/QJsonObject"
+#include "QtCore/QThread"
+#include "QtWidgets/QApplication"
+#include "QtWidgets/QLabel"
+#include "QtX11Extras/QX11Info"
+
+#include "xframelesswidget.h"
+
+#include <X11/Xlib.h>
+#include <X11/Xatom.h>
+#include <X11/extensions/XTest.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	constexpr int kMargin = 10;
+	constexpr int kSettleMs = 150;
+
+	struct Counters
+	{
+		std::atomic<long> requests{ 0 };
+		std::atomic<long> replies{ 0 };
+		std::atomic<long> flushes{ 0 };
+	};
+
+	struct Snapshot
+	{
+		long requests = 0;
+		long replies = 0;
+		long flushes = 0;
+
+		Snapshot operator-(const Snapshot &o) const
+		{
+			Snapshot s;
+			s.requests = requests - o.requests;
+			s.replies = replies - o.replies;
+			s.flushes = flushes - o.flushes;
+			return s;
+		}
+	};
+
+	size_t pad4(size_t n)
+	{
+		return (n + 3) & ~static_cast<size_t>(3);
+	}
+
+	/*!
+	 * Splits one direction of an X connection into messages. Only headers
+	 * are looked at, bodies are skipped without copying.
+	 */
+	class StreamParser final
+	{
+	public:
+		StreamParser(bool fromClient, bool *bigEndian, Counters *counters)
+			: _fromClient(fromClient)
+			, _bigEndian(bigEndian)
+			, _counters(counters)
+		{
+		}
+
+		void feed(const unsigned char *data, size_t size)
+		{
+			while (size > 0)
+			{
+				if (_remaining > 0)
+				{
+					const size_t take = std::min(_remaining, size);
+					_remaining -= take;
+					data += take;
+					size -= take;
+					continue;
+				}
+				_head.push_back(*data++);
+				--size;
+				size_t total = 0;
+				if (messageSize(&total))
+				{
+					_remaining = total - _head.size();
+					_head.clear();
+				}
+			}
+		}
+
+	private:
+		uint32_t read16(size_t at) const
+		{
+			return *_bigEndian ? (_head[at] << 8) | _head[at + 1] : _head[at] | (_head[at + 1] << 8);
+		}
+
+		uint32_t read32(size_t at) const
+		{
+			return *_bigEndian
+				? (read16(at) << 16) | read16(at + 2)
+				: read16(at) | (read16(at + 2) << 16);
+		}
+
+		// true once the header is complete, total is the whole message size;
+		bool messageSize(size_t *total)
+		{
+			if (!_setupDone)
+			{
+				if (_fromClient)
+				{
+					if (_head.size() < 12)
+					{
+						return false;
+					}
+					*_bigEndian = _head[0] == 'B';
+					*total = 12 + pad4(read16(6)) + pad4(read16(8));
+				}
+				else
+				{
+					if (_head.size() < 8)
+					{
+						return false;
+					}
+					*total = 8 + read16(6) * 4;
+				}
+				_setupDone = true;
+				return true;
+			}
+
+			if (_fromClient)
+			{
+				if (_head.size() < 4)
+				{
+					return false;
+				}
+				size_t length = read16(2);
+				if (length == 0)
+				{
+					// BIG-REQUESTS, the length follows in 32 bits;
+					if (_head.size() < 8)
+					{
+						return false;
+					}
+					length = read32(4);
+				}
+				*total = length * 4;
+				++_counters->requests;
+				return true;
+			}
+
+			if (_head.size() < 32)
+			{
+				return false;
+			}
+			const int type = _head[0] & 0x7f;
+			// replies and GenericEvents carry extra data;
+			*total = 32 + (type == 1 || type == 35 ? read32(4) * 4 : 0);
+			if (type == 1)
+			{
+				++_counters->replies;
+			}
+			return true;
+		}
+
+		bool _fromClient;
+		bool *_bigEndian;
+		Counters *_counters;
+		bool _setupDone = false;
+		std::vector<unsigned char> _head;
+		size_t _remaining = 0;
+	};
+
+	int connectUnix(const std::string &path, bool abstract)
+	{
+		const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+		sockaddr_un addr;
+		memset(&addr, 0, sizeof(addr));
+		addr.sun_family = AF_UNIX;
+		// the abstract name starts with a nul byte;
+		const size_t offset = abstract ? 1 : 0;
+		strncpy(addr.sun_path + offset, path.c_str(), sizeof(addr.sun_path) - 1 - offset);
+		const socklen_t len = static_cast<socklen_t>(offsetof(sockaddr_un, sun_path) + offset + path.size());
+		if (::connect(fd, reinterpret_cast<sockaddr *>(&addr), abstract ? len : sizeof(addr)) != 0)
+		{
+			close(fd);
+			return -1;
+		}
+		return fd;
+	}
+
+	/*!
+	 * Listens on a free local display number and relays every connection to
+	 * the real server, counting on the way. Runs on its own thread.
+	 */
+	class CountingProxy final
+	{
+	public:
+		~CountingProxy()
+		{
+			_quit = true;
+			if (_thread.joinable())
+			{
+				_thread.join();
+			}
+			for (const Link &link : _links)
+			{
+				close(link.client);
+				close(link.server);
+				delete link.up;
+				delete link.down;
+				delete link.bigEndian;
+			}
+			if (_listener >= 0)
+			{
+				close(_listener);
+				unlink(_path.c_str());
+			}
+		}
+
+		// returns the proxy display name, empty on failure;
+		std::string start(const std::string &upstreamDisplay)
+		{
+			// only local displays, ":n" or ":n.s";
+			if (upstreamDisplay.empty() || upstreamDisplay[0] != ':')
+			{
+				return std::string();
+			}
+			_upstream = "/tmp/.X11-unix/X" + upstreamDisplay.substr(1, upstreamDisplay.find('.') - 1);
+
+			for (int n = 90; n < 190; ++n)
+			{
+				const std::string path = "/tmp/.X11-unix/X" + std::to_string(n);
+				if (access(path.c_str(), F_OK) == 0
+					|| access(("/tmp/.X" + std::to_string(n) + "-lock").c_str(), F_OK) == 0)
+				{
+					continue;
+				}
+				_listener = socket(AF_UNIX, SOCK_STREAM, 0);
+				sockaddr_un addr;
+				memset(&addr, 0, sizeof(addr));
+				addr.sun_family = AF_UNIX;
+				strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+				if (bind(_listener, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) == 0
+					&& listen(_listener, 8) == 0)
+				{
+					_path = path;
+					_thread = std::thread([this]() { run(); });
+					return ":" + std::to_string(n);
+				}
+				close(_listener);
+				_listener = -1;
+			}
+			return std::string();
+		}
+
+		Snapshot snapshot() const
+		{
+			Snapshot s;
+			s.requests = _counters.requests;
+			s.replies = _counters.replies;
+			s.flushes = _counters.flushes;
+			return s;
+		}
+
+	private:
+		struct Link
+		{
+			int client;
+			int server;
+			bool *bigEndian;
+			StreamParser *up;
+			StreamParser *down;
+		};
+
+		void accept()
+		{
+			const int client = ::accept(_listener, Q_NULLPTR, Q_NULLPTR);
+			if (client < 0)
+			{
+				return;
+			}
+			int server = connectUnix(_upstream, true);
+			if (server < 0)
+			{
+				server = connectUnix(_upstream, false);
+			}
+			if (server < 0)
+			{
+				close(client);
+				return;
+			}
+			bool *bigEndian = new bool(false);
+			_links.push_back({ client, server, bigEndian,
+				new StreamParser(true, bigEndian, &_counters),
+				new StreamParser(false, bigEndian, &_counters) });
+		}
+
+		// false when the connection is gone;
+		bool relay(int from, int to, StreamParser *parser, bool countFlush)
+		{
+			unsigned char buffer[65536];
+			const ssize_t n = read(from, buffer, sizeof(buffer));
+			if (n <= 0)
+			{
+				return false;
+			}
+			if (countFlush)
+			{
+				++_counters.flushes;
+			}
+			parser->feed(buffer, static_cast<size_t>(n));
+			ssize_t written = 0;
+			while (written < n)
+			{
+				const ssize_t w = write(to, buffer + written, static_cast<size_t>(n - written));
+				if (w <= 0)
+				{
+					return false;
+				}
+				written += w;
+			}
+			return true;
+		}
+
+		void run()
+		{
+			while (!_quit)
+			{
+				std::vector<pollfd> fds;
+				fds.push_back({ _listener, POLLIN, 0 });
+				for (const Link &link : _links)
+				{
+					fds.push_back({ link.client, POLLIN, 0 });
+					fds.push_back({ link.server, POLLIN, 0 });
+				}
+				if (poll(fds.data(), fds.size(), 50) <= 0)
+				{
+					continue;
+				}
+
+				if (fds[0].revents & POLLIN)
+				{
+					accept();
+				}
+				for (size_t i = 0; i < _links.size(); ++i)
+				{
+					Link &link = _links[i];
+					bool alive = true;
+					if (fds[1 + i * 2].revents & (POLLIN | POLLHUP))
+					{
+						alive = relay(link.client, link.server, link.up, true);
+					}
+					if (alive && (fds[2 + i * 2].revents & (POLLIN | POLLHUP)))
+					{
+						alive = relay(link.server, link.client, link.down, false);
+					}
+					if (!alive)
+					{
+						close(link.client);
+						close(link.server);
+						delete link.up;
+						delete link.down;
+						delete link.bigEndian;
+						_links.erase(_links.begin() + i);
+						break;
+					}
+				}
+			}
+		}
+
+		std::string _upstream;
+		std::string _path;
+		int _listener = -1;
+		std::thread _thread;
+		std::atomic<bool> _quit{ false };
+		std::vector<Link> _links;
+		Counters _counters;
+	};
+
+	void settle()
+	{
+		QElapsedTimer timer;
+		timer.start();
+		while (timer.elapsed() < kSettleMs)
+		{
+			QCoreApplication::processEvents(QEventLoop::AllEvents, 10);
+			QThread::msleep(5);
+		}
+		XSync(QX11Info::display(), False);
+		QCoreApplication::processEvents();
+	}
+
+	QJsonObject toJson(const Snapshot &s)
+	{
+		QJsonObject obj;
+		obj.insert("requests", static_cast<int>(s.requests));
+		obj.insert("replies", static_cast<int>(s.replies));
+		obj.insert("flushes", static_cast<int>(s.flushes));
+		return obj;
+	}
+
+	// _NET_WM_NAME of the window manager, empty without an EWMH one;
+	QString windowManagerName(Display *display)
+	{
+		const Window root = DefaultRootWindow(display);
+		const Atom check = XInternAtom(display, "_NET_SUPPORTING_WM_CHECK", False);
+		Atom type = None;
+		int format = 0;
+		unsigned long nitems = 0;
+		unsigned long bytesAfter = 0;
+		unsigned char *data = Q_NULLPTR;
+		Window wm = None;
+		if (XGetWindowProperty(display, root, check, 0, 1, False, XA_WINDOW, &type, &format,
+			&nitems, &bytesAfter, &data) == Success && data)
+		{
+			if (type == XA_WINDOW && format == 32 && nitems == 1)
+			{
+				wm = *reinterpret_cast<const Window *>(data);
+			}
+			XFree(data);
+		}
+		if (wm == None)
+		{
+			return QString();
+		}
+
+		data = Q_NULLPTR;
+		QString name;
+		if (XGetWindowProperty(display, wm, XInternAtom(display, "_NET_WM_NAME", False), 0, 256,
+			False, XInternAtom(display, "UTF8_STRING", False), &type, &format, &nitems,
+			&bytesAfter, &data) == Success && data)
+		{
+			name = QString::fromUtf8(reinterpret_cast<const char *>(data), static_cast<int>(nitems));
+			XFree(data);
+		}
+		return name;
+	}
+
+	/*!
+	 * What the counts depend on besides the library: Qt, the X server and
+	 * the window manager. Written next to the budgets, so a mismatch can
+	 * be reported.
+	 */
+	QJsonObject describeSetup(Display *display)
+	{
+		const int screen = DefaultScreen(display);
+		QJsonObject obj;
+		obj.insert("qt", QString::fromLatin1(qVersion()));
+		obj.insert("server", QString("%1 %2").arg(QString::fromLatin1(ServerVendor(display)))
+			.arg(VendorRelease(display)));
+		obj.insert("screen", QString("%1x%2x%3").arg(DisplayWidth(display, screen))
+			.arg(DisplayHeight(display, screen)).arg(DefaultDepth(display, screen)));
+		obj.insert("wm", windowManagerName(display));
+		return obj;
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	// the proxy has to be in place before Qt connects;
+	const char *realDisplay = getenv("DISPLAY");
+	CountingProxy proxy;
+	const std::string proxyDisplay = proxy.start(realDisplay ? realDisplay : "");
+	if (proxyDisplay.empty())
+	{
+		fprintf(stderr, "cannot proxy DISPLAY=%s, a local display like :99 is needed\n",
+			realDisplay ? realDisplay : "");
+		return 1;
+	}
+	setenv("DISPLAY", proxyDisplay.c_str(), 1);
+	setenv("QT_QPA_PLATFORM", "xcb", 1);
+
+	QApplication a(argc, argv);
+
+	QCommandLineParser parser;
+	parser.addHelpOption();
+	parser.addOption({ "budget", "Budget file to check against.", "file" });
+	parser.addOption({ "update-budget", "Write the measured counts to the budget file." });
+	parser.addOption({ "output", "Write the JSON report to file.", "file" });
+	parser.process(a);
+
+	// the pointer is driven over a direct connection, which is not counted;
+	Display *control = XOpenDisplay(realDisplay);
+	int event = 0;
+	int error = 0;
+	int major = 0;
+	int minor = 0;
+	if (!control || !XTestQueryExtension(control, &event, &error, &major, &minor))
+	{
+		qCritical("XTest is required");
+		return 1;
+	}
+	const auto motion = [control](const QPoint &pos) {
+		XTestFakeMotionEvent(control, -1, pos.x(), pos.y(), CurrentTime);
+		XSync(control, False);
+	};
+	const auto button = [control](bool press) {
+		XTestFakeButtonEvent(control, 1, press ? True : False, CurrentTime);
+		XSync(control, False);
+	};
+
+	XFramelessWidgetWithCaption *w = Q_NULLPTR;
+	XFramelessWidgetWithCaption other;
+	other.setContentWidget(new QLabel("other"));
+
+	// operations run in this order, each on the state the previous one left;
+	const std::vector<std::pair<QString, std::function<void()> > > operations = {
+		{ "construct", [&]() {
+			w = new XFramelessWidgetWithCaption();
+			w->setContentWidget(new QLabel("xrequests"));
+			w->setMainLayoutMargins(kMargin, kMargin, kMargin, kMargin);
+			w->resize(640, 480);
+		} },
+		{ "show", [&]() { w->show(); } },
+		{ "showCenter", [&]() { other.showCenter(); } },
+		{ "maximize", [&]() { w->showMaximized(); } },
+		{ "restore", [&]() { w->showNormal(); } },
+		{ "resize_step", [&]() { w->resize(w->width() + 8, w->height() + 8); } },
+		{ "hover_edge", [&]() {
+			const QRect g = w->geometry();
+			motion(QPoint(g.right() - kMargin / 2, g.center().y()));
+		} },
+		{ "start_drag", [&]() {
+			QWidget *caption = w->captionItf()->widget();
+			const QPoint pos = caption->mapToGlobal(QPoint(caption->width() / 3, caption->height() / 2));
+			motion(pos);
+			button(true);
+			motion(pos + QPoint(4, 4));
+			button(false);
+		} },
+		{ "set_title", [&]() { w->setWindowTitle("xrequests 42%"); } },
+	};
+
+	// what settling alone costs, taken off every operation;
+	settle();
+	Snapshot before = proxy.snapshot();
+	settle();
+	const Snapshot baseline = proxy.snapshot() - before;
+
+	QJsonObject results;
+	for (const auto &op : operations)
+	{
+		before = proxy.snapshot();
+		op.second();
+		settle();
+		Snapshot cost = proxy.snapshot() - before - baseline;
+		cost.requests = qMax(0L, cost.requests);
+		cost.replies = qMax(0L, cost.replies);
+		cost.flushes = qMax(0L, cost.flushes);
+		results.insert(op.first, toJson(cost));
+	}
+	delete w;
+
+	int ret = 0;
+	const QJsonObject setup = describeSetup(control);
+	XCloseDisplay(control);
+	const QString budgetFile = parser.value("budget");
+	if (parser.isSet("update-budget"))
+	{
+		QFile file(budgetFile);
+		if (budgetFile.isEmpty() || !file.open(QFile::WriteOnly))
+		{
+			qCritical("cannot write the budget file '%s'", qPrintable(budgetFile));
+			return 1;
+		}
+		QJsonObject budget = results;
+		budget.insert("setup", setup);
+		file.write(QJsonDocument(budget).toJson());
+	}
+	else if (!budgetFile.isEmpty())
+	{
+		QFile file(budgetFile);
+		if (!file.open(QFile::ReadOnly))
+		{
+			qCritical("cannot read the budget file '%s'", qPrintable(budgetFile));
+			return 1;
+		}
+		const QJsonObject budget = QJsonDocument::fromJson(file.readAll()).object();
+		// counts from another setup are still checked, but may not compare;
+		const QJsonObject budgetSetup = budget.value("setup").toObject();
+		for (auto it = setup.constBegin(); it != setup.constEnd(); ++it)
+		{
+			if (budgetSetup.value(it.key()) != it.value())
+			{
+				fprintf(stderr, "warning: budget %s is '%s', this run '%s'\n", qPrintable(it.key()),
+					qPrintable(budgetSetup.value(it.key()).toString()),
+					qPrintable(it.value().toString()));
+			}
+		}
+		for (auto it = results.constBegin(); it != results.constEnd(); ++it)
+		{
+			const QJsonObject measured = it.value().toObject();
+			const QJsonObject limits = budget.value(it.key()).toObject();
+			for (auto limit = limits.constBegin(); limit != limits.constEnd(); ++limit)
+			{
+				const int value = measured.value(limit.key()).toInt();
+				if (value > limit.value().toInt())
+				{
+					fprintf(stderr, "%s: %d %s, budget %d\n", qPrintable(it.key()), value,
+						qPrintable(limit.key()), limit.value().toInt());
+					ret = 1;
+				}
+			}
+		}
+	}
+
+	QJsonObject root;
+	root.insert("benchmark", "xrequests");
+	root.insert("setup", setup);
+	root.insert("results", results);
+	const QByteArray json = QJsonDocument(root).toJson();
+	if (parser.isSet("output"))
+	{
+		QFile file(parser.value("output"));
+		if (!file.open(QFile::WriteOnly))
+		{
+			qCritical("cannot write %s", qPrintable(file.fileName()));
+			return 1;
+		}
+		file.write(json);
+	}
+	else
+	{
+		fwrite(json.constData(), 1, json.size(), stdout);
+	}
+	return ret;
+}
@@ -1,14 +1,54 @@
 #ifndef CAPTIONITF_H
 #define CAPTIONITF_H
 
+#include "QtCore/QPoint"
 #include "QtCore/QString"
+#include "QtGui/QColor"
+#include "QtGui/QIcon"
 #include "QtGui/QPixmap"
 
 class QWidget;
 
+/*!
+ * Colors, metrics and button glyphs of a caption. Invalid colors fall back
+ * to the caption's palette, null glyphs to the style's title bar icons.
+ * CaptionWidget shows no style icons until setTheme() is called, so the
+ * buttons can be drawn by a style sheet alone.
+ */
+struct CaptionTheme
+{
+	QColor background;
+	QColor titleColor;
+	QColor buttonHoverColor;
+	QColor buttonPressedColor;
+	QColor closeHoverColor = QColor(232, 17, 35);
+
+	int height = 25;
+	int buttonWidth = 30;
+	int buttonHeight = 20;
+	int glyphSize = 10;
+	int titlePixelSize = 12;
+	bool titleBold = true;
+
+	QIcon moreGlyph;
+	QIcon minimizeGlyph;
+	QIcon maximizeGlyph;
+	QIcon closeGlyph;
+};
+
 class CaptionIterface
 {
 public:
+	enum Part
+	{
+		kIcon = 0x01,
+		kTitleText = 0x02,
+		kMoreButton = 0x04,
+		kMinimizeButton = 0x08,
+		kMaximizeButton = 0x10,
+		kCloseButton = 0x20,
+	};
+
 	virtual QWidget* widget() = 0;
 	virtual void showIcon(bool b) = 0;
 	virtual void setIcon(const QPixmap& pixmap) = 0;
@@ -26,6 +66,16 @@ public:
 	virtual void showCloseButton(bool b) = 0;
 	virtual void changeLeftSpacerSize(const int w, const int h) = 0;
 	virtual void changeRightSpacerSize(const int w, const int h) = 0;
+	// Part flags of the parts not explicitly hidden;
+	virtual int visibleParts() const = 0;
+	virtual void setVisibleParts(const int parts) = 0;
+	// themes are applied through a QProxyStyle and the palette, no style sheet
+	// is involved; a style sheet set on the caption still takes precedence;
+	virtual CaptionTheme theme() const = 0;
+	virtual void setTheme(const CaptionTheme &theme) = 0;
+	// whether pos (caption coordinates) may start a window drag, i.e. it is
+	// not over a button or another interactive part;
+	virtual bool isDragArea(const QPoint &pos) const = 0;
 };
 
 #endif // CAPTIONITF_H;
\ No newline at end of file
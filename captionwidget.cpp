@@ -1,12 +1,82 @@
 #include "captionwidget.h"
 #include "ui_captionwidget.h"
 
+#include "QtCore/QPointer"
 #include "QtGui/QFont"
 #include "QtGui/QPainter"
+#include "QtWidgets/QApplication"
 #include "QtWidgets/QLabel"
+#include "QtWidgets/QProxyStyle"
 #include "QtWidgets/QStyleOption"
 #include "QtWidgets/QPushButton"
 
+namespace
+{
+	/*!
+	 * Paints the caption buttons from the owning caption's CaptionTheme and
+	 * leaves everything else to the application style. One instance is 
+	 * shared by all captions, so theming a caption costs no style sheet 
+	 * parsing or polishing.
+	 */
+	class CaptionStyle final : public QProxyStyle
+	{
+	public:
+		static CaptionStyle *instance()
+		{
+			static QPointer<CaptionStyle> self;
+			if (!self)
+			{
+				self = new CaptionStyle;
+				self->setParent(qApp);
+			}
+			return self;
+		}
+
+		void drawControl(ControlElement element, const QStyleOption *option, QPainter *painter,
+			const QWidget *widget = Q_NULLPTR) const override
+		{
+			const CaptionWidget *caption = widget 
+				? qobject_cast<const CaptionWidget *>(widget->parentWidget()) : Q_NULLPTR;
+			if (element != CE_PushButtonBevel || !caption)
+			{
+				QProxyStyle::drawControl(element, option, painter, widget);
+				return;
+			}
+
+			const CaptionTheme theme = caption->theme();
+			QColor color;
+			if (option->state & State_Sunken)
+			{
+				color = theme.buttonPressedColor.isValid() 
+					? theme.buttonPressedColor : option->palette.color(QPalette::Mid);
+			}
+			else if (option->state & State_MouseOver)
+			{
+				if (widget->objectName() == QLatin1String("btnClose") && theme.closeHoverColor.isValid())
+				{
+					color = theme.closeHoverColor;
+				}
+				else
+				{
+					color = theme.buttonHoverColor.isValid()
+						? theme.buttonHoverColor : option->palette.color(QPalette::Midlight);
+				}
+			}
+			if (color.isValid())
+			{
+				painter->fillRect(option->rect, color);
+			}
+		}
+	};
+
+	// SP_CustomBase for no fallback;
+	void applyGlyph(QPushButton *button, const QIcon &glyph, QStyle::StandardPixmap fallback)
+	{
+		button->setIcon(glyph.isNull() && fallback != QStyle::SP_CustomBase
+			? button->style()->standardIcon(fallback, Q_NULLPTR, button) : glyph);
+	}
+}
+
 CaptionWidget::CaptionWidget(QWidget * parent) 
 	: QWidget(parent), ui(new Ui::CaptionWidget)
 {
@@ -40,11 +110,15 @@ CaptionWidget::~CaptionWidget() {
 
 void CaptionWidget::paintEvent(QPaintEvent *event)
 {
-	/* For setStyleSheet function well, why does it need; */
-	QStyleOption opt;
-	opt.init(this);
-	QPainter p(this);
-	style()->drawPrimitive(QStyle::PE_Widget, &opt, &p, this);
+	/* Only a style sheet background needs PE_Widget, a theme background is
+	   filled through the palette; */
+	if (testAttribute(Qt::WA_StyleSheet))
+	{
+		QStyleOption opt;
+		opt.init(this);
+		QPainter p(this);
+		style()->drawPrimitive(QStyle::PE_Widget, &opt, &p, this);
+	}
 
 	QWidget::paintEvent(event);
 }
@@ -60,6 +134,7 @@ void CaptionWidget::showIcon(bool b) {
 
 void CaptionWidget::setIcon(const QPixmap& pixmap) {
 	ui->iconLbl->setPixmap(pixmap);
+	emit iconChanged(pixmap);
 }
 
 void CaptionWidget::showTitleText(bool b) {
@@ -121,6 +196,85 @@ void CaptionWidget::changeRightSpacerSize(const int w, const int h) {
 	ui->rightSpacer->changeSize(w, h);
 }
 
+int CaptionWidget::visibleParts() const {
+	int parts = 0;
+	parts |= ui->iconLbl->isHidden() ? 0 : kIcon;
+	parts |= ui->titleLbl->isHidden() ? 0 : kTitleText;
+	parts |= ui->btnMore->isHidden() ? 0 : kMoreButton;
+	parts |= ui->btnMinimize->isHidden() ? 0 : kMinimizeButton;
+	parts |= ui->btnMaximize->isHidden() ? 0 : kMaximizeButton;
+	parts |= ui->btnClose->isHidden() ? 0 : kCloseButton;
+	return parts;
+}
+
+void CaptionWidget::setVisibleParts(const int parts) {
+	showIcon((parts & kIcon) != 0);
+	showTitleText((parts & kTitleText) != 0);
+	showMoreButton((parts & kMoreButton) != 0);
+	showMinimizeButton((parts & kMinimizeButton) != 0);
+	showMaximizeButton((parts & kMaximizeButton) != 0);
+	showCloseButton((parts & kCloseButton) != 0);
+}
+
+CaptionTheme CaptionWidget::theme() const {
+	return _theme;
+}
+
+/*!
+ * Until the first theme the buttons keep the application style and the
+ * metrics of the .ui file, so style sheets and hand-tuned layouts look as
+ * they did.
+ */
+void CaptionWidget::setTheme(const CaptionTheme &theme) {
+	_theme = theme;
+	for (QPushButton *btn : { ui->btnMore, ui->btnMinimize, ui->btnMaximize, ui->btnClose }) {
+		if (btn->style() != CaptionStyle::instance()) {
+			btn->setStyle(CaptionStyle::instance());
+			btn->setAttribute(Qt::WA_Hover);
+		}
+	}
+	applyTheme();
+}
+
+void CaptionWidget::applyTheme() {
+	const CaptionTheme &theme = _theme;
+
+	// start over from the inherited palette so invalid colors fall back;
+	setPalette(QPalette());
+	QPalette pal = palette();
+	if (theme.background.isValid()) {
+		pal.setColor(QPalette::Window, theme.background);
+	}
+	if (theme.titleColor.isValid()) {
+		pal.setColor(QPalette::WindowText, theme.titleColor);
+	}
+	setPalette(pal);
+	setAutoFillBackground(theme.background.isValid());
+	setFixedHeight(theme.height);
+
+	QFont ft = ui->titleLbl->font();
+	ft.setPixelSize(theme.titlePixelSize);
+	ft.setBold(theme.titleBold);
+	ui->titleLbl->setFont(ft);
+
+	const QSize buttonSize(theme.buttonWidth, theme.buttonHeight);
+	const QSize glyphSize(theme.glyphSize, theme.glyphSize);
+	for (QPushButton *btn : { ui->btnMinimize, ui->btnMaximize, ui->btnClose }) {
+		btn->setFixedSize(buttonSize);
+		btn->setIconSize(glyphSize);
+	}
+	ui->btnMore->setIconSize(glyphSize);
+	applyGlyph(ui->btnMore, theme.moreGlyph, QStyle::SP_CustomBase);
+	applyGlyph(ui->btnMinimize, theme.minimizeGlyph, QStyle::SP_TitleBarMinButton);
+	applyGlyph(ui->btnMaximize, theme.maximizeGlyph, QStyle::SP_TitleBarMaxButton);
+	applyGlyph(ui->btnClose, theme.closeGlyph, QStyle::SP_TitleBarCloseButton);
+	update();
+}
+
+bool CaptionWidget::isDragArea(const QPoint &pos) const {
+	return rect().contains(pos) && childAt(pos) == Q_NULLPTR;
+}
+
 void CaptionWidget::moreButtonClicked() {
     QPoint pos_ = ui->btnMore->pos() + QPoint(0, ui->btnMore->height());
     emit moreClicked(pos_, this->mapToGlobal(pos_));
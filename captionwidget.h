@@ -44,17 +44,28 @@ public:
 	void showCloseButton(bool b) override;
 	void changeLeftSpacerSize(const int w, const int h) override;
 	void changeRightSpacerSize(const int w, const int h) override;
+	int visibleParts() const override;
+	void setVisibleParts(const int parts) override;
+	CaptionTheme theme() const override;
+	void setTheme(const CaptionTheme &theme) override;
+	bool isDragArea(const QPoint &pos) const override;
 
 	Q_SIGNAL void moreClicked(const QPoint& wgtPos, const QPoint& globalPos);
 	Q_SIGNAL void minimizeClicked();
 	Q_SIGNAL void maximizeClicked();
 	Q_SIGNAL void closed();
+	// the window takes it as its icon;
+	Q_SIGNAL void iconChanged(const QPixmap& pixmap);
 
 protected:
 	virtual void paintEvent(QPaintEvent *event);
 
 private:
 	Ui::CaptionWidget *ui;
+	CaptionTheme _theme;
+
+	// the application style's title bar icons stand in for missing glyphs;
+	void applyTheme();
 
 	Q_SLOT void moreButtonClicked();
 };
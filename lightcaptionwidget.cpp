@@ -0,0 +1,528 @@
+#include "lightcaptionwidget.h"
+
+#include "QtGui/QMouseEvent"
+#include "QtGui/QPainter"
+#include "QtWidgets/QStyle"
+
+namespace
+{
+	// the fixed sizes of captionwidget.ui;
+	constexpr int kIconWidth = 20;
+	constexpr int kMoreButtonWidth = 10;
+	constexpr int kMoreButtonHeight = 8;
+
+	// item kinds besides CaptionIterface::Part;
+	constexpr int kLeftSpacer = 0x100;
+	constexpr int kRightSpacer = 0x200;
+
+	constexpr int kButtonParts = CaptionIterface::kMoreButton | CaptionIterface::kMinimizeButton
+		| CaptionIterface::kMaximizeButton | CaptionIterface::kCloseButton;
+}
+
+LightCaptionWidget::LightCaptionWidget(QWidget * parent)
+	: QWidget(parent)
+{
+	setSizePolicy(QSizePolicy::Preferred, QSizePolicy::Fixed);
+	setMouseTracking(true);
+
+	const int parts[] = { kIcon, kLeftSpacer, kTitleText, kRightSpacer,
+		kMoreButton, kMinimizeButton, kMaximizeButton, kCloseButton };
+	for (const int part : parts)
+	{
+		Item item;
+		item.part = part;
+		_items.append(item);
+	}
+	setTheme(CaptionTheme());
+}
+
+LightCaptionWidget::~LightCaptionWidget() {
+}
+
+QWidget* LightCaptionWidget::widget()
+{
+	return this;
+}
+
+void LightCaptionWidget::showIcon(bool b) {
+	setPartVisible(kIcon, b);
+}
+
+void LightCaptionWidget::setIcon(const QPixmap& pixmap) {
+	_icon = pixmap;
+	update();
+	emit iconChanged(pixmap);
+}
+
+void LightCaptionWidget::showTitleText(bool b) {
+	setPartVisible(kTitleText, b);
+}
+
+void LightCaptionWidget::setTitleText(const QString& text) {
+	if (_title == text) {
+		return;
+	}
+	_title = text;
+	relayout();
+}
+
+void LightCaptionWidget::insertWidget(int index, QWidget *widget, int stretch /*= 0*/,
+	Qt::Alignment alignment /*= Qt::Alignment()*/) {
+	Q_ASSERT(widget);
+	Item item;
+	item.widget = widget;
+	item.stretch = stretch;
+	item.alignment = alignment;
+	_items.insert(qBound(0, index < 0 ? _items.size() : index, _items.size()), item);
+
+	// same as a layout: show it unless it was hidden explicitly;
+	const bool hidden = widget->isHidden() && widget->testAttribute(Qt::WA_WState_ExplicitShowHide);
+	widget->setParent(this);
+	widget->installEventFilter(this);
+	widget->setVisible(!hidden);
+	relayout();
+}
+
+int LightCaptionWidget::indexOfLogo() const {
+	return indexOfPart(kIcon);
+}
+
+int LightCaptionWidget::indexOfTitleText() const {
+	return indexOfPart(kTitleText);
+}
+
+int LightCaptionWidget::indexOfMoreButton() const {
+	return indexOfPart(kMoreButton);
+}
+
+int LightCaptionWidget::indexOfWidget(QWidget * const wgt) const {
+	for (int i = 0; i < _items.size(); ++i) {
+		if (_items[i].part == 0 && _items[i].widget == wgt) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+void LightCaptionWidget::showMoreButton(bool b) {
+	setPartVisible(kMoreButton, b);
+}
+
+void LightCaptionWidget::showMinimizeButton(bool b) {
+	setPartVisible(kMinimizeButton, b);
+}
+
+void LightCaptionWidget::showMaximizeButton(bool b) {
+	setPartVisible(kMaximizeButton, b);
+}
+
+void LightCaptionWidget::showCloseButton(bool b) {
+	setPartVisible(kCloseButton, b);
+}
+
+void LightCaptionWidget::changeLeftSpacerSize(const int w, const int h) {
+	_items[indexOfPart(kLeftSpacer)].spacerSize = QSize(w, h);
+	relayout();
+}
+
+void LightCaptionWidget::changeRightSpacerSize(const int w, const int h) {
+	_items[indexOfPart(kRightSpacer)].spacerSize = QSize(w, h);
+	relayout();
+}
+
+int LightCaptionWidget::visibleParts() const {
+	int parts = 0;
+	for (const Item &item : _items) {
+		if (item.visible && item.part < kLeftSpacer) {
+			parts |= item.part;
+		}
+	}
+	return parts;
+}
+
+void LightCaptionWidget::setVisibleParts(const int parts) {
+	for (Item &item : _items) {
+		if (item.part != 0 && item.part < kLeftSpacer) {
+			item.visible = (parts & item.part) != 0;
+		}
+	}
+	relayout();
+}
+
+CaptionTheme LightCaptionWidget::theme() const {
+	return _theme;
+}
+
+void LightCaptionWidget::setTheme(const CaptionTheme &theme) {
+	_theme = theme;
+	setFixedHeight(theme.height);
+	updateTitleFont();
+
+	for (Item &item : _items) {
+		QStyle::StandardPixmap sp = QStyle::SP_CustomBase;
+		switch (item.part) {
+		case kMoreButton:
+			item.glyph = theme.moreGlyph;
+			break;
+		case kMinimizeButton:
+			item.glyph = theme.minimizeGlyph;
+			sp = QStyle::SP_TitleBarMinButton;
+			break;
+		case kMaximizeButton:
+			item.glyph = theme.maximizeGlyph;
+			sp = QStyle::SP_TitleBarMaxButton;
+			break;
+		case kCloseButton:
+			item.glyph = theme.closeGlyph;
+			sp = QStyle::SP_TitleBarCloseButton;
+			break;
+		default:
+			continue;
+		}
+		if (item.glyph.isNull() && sp != QStyle::SP_CustomBase) {
+			item.glyph = style()->standardIcon(sp, Q_NULLPTR, this);
+		}
+	}
+	relayout();
+}
+
+bool LightCaptionWidget::isDragArea(const QPoint &pos) const {
+	return rect().contains(pos) && buttonAt(pos) == 0 && childAt(pos) == Q_NULLPTR;
+}
+
+QSize LightCaptionWidget::sizeHint() const {
+	int w = 0;
+	for (const Item &item : _items) {
+		w += itemWidth(item);
+	}
+	return QSize(w, _theme.height);
+}
+
+bool LightCaptionWidget::event(QEvent *event)
+{
+	switch (event->type()) {
+	case QEvent::FontChange:
+		// the title keeps the theme's size and weight in the new family;
+		updateTitleFont();
+		relayout();
+		break;
+	case QEvent::LayoutRequest:
+		// an inserted widget changed its size hint;
+		relayout();
+		break;
+	case QEvent::ChildRemoved:
+		for (int i = _items.size() - 1; i >= 0; --i) {
+			if (_items[i].part == 0 && (!_items[i].widget || _items[i].widget->parent() != this)) {
+				_items.remove(i);
+			}
+		}
+		relayout();
+		break;
+	default:
+		break;
+	}
+	return QWidget::event(event);
+}
+
+bool LightCaptionWidget::eventFilter(QObject *watched, QEvent *event)
+{
+	if ((event->type() == QEvent::Show || event->type() == QEvent::Hide)
+		&& watched->parent() == this) {
+		relayout();
+	}
+	return QWidget::eventFilter(watched, event);
+}
+
+void LightCaptionWidget::leaveEvent(QEvent *event)
+{
+	if (_hoveredPart != 0) {
+		_hoveredPart = 0;
+		update();
+	}
+	QWidget::leaveEvent(event);
+}
+
+/*
+	Events over the buttons are taken here, everything else is ignored so it
+	reaches XFramelessWidget, which moves the window;
+*/
+void LightCaptionWidget::mouseMoveEvent(QMouseEvent *event)
+{
+	const int part = buttonAt(event->pos());
+	if (part != _hoveredPart) {
+		_hoveredPart = part;
+		update();
+	}
+	event->setAccepted(_pressedPart != 0);
+}
+
+void LightCaptionWidget::mousePressEvent(QMouseEvent *event)
+{
+	const int part = event->button() == Qt::LeftButton ? buttonAt(event->pos()) : 0;
+	if (part == 0) {
+		event->ignore();
+		return;
+	}
+	_pressedPart = part;
+	update();
+}
+
+void LightCaptionWidget::mouseReleaseEvent(QMouseEvent *event)
+{
+	if (_pressedPart == 0 || event->button() != Qt::LeftButton) {
+		event->ignore();
+		return;
+	}
+	const int part = _pressedPart;
+	_pressedPart = 0;
+	update();
+	if (buttonAt(event->pos()) == part) {
+		trigger(part);
+	}
+}
+
+void LightCaptionWidget::paintEvent(QPaintEvent *event)
+{
+	Q_UNUSED(event);
+	QPainter p(this);
+	if (_theme.background.isValid()) {
+		p.fillRect(rect(), _theme.background);
+	}
+
+	for (const Item &item : _items) {
+		if (!item.visible || item.rect.isEmpty()) {
+			continue;
+		}
+
+		if (item.part == kIcon && !_icon.isNull()) {
+			const QSize size = (_icon.size() / _icon.devicePixelRatio()).scaled(
+				item.rect.size().boundedTo(_icon.size() / _icon.devicePixelRatio()), Qt::KeepAspectRatio);
+			QRect target(QPoint(), size);
+			target.moveCenter(item.rect.center());
+			p.drawPixmap(target, _icon);
+		}
+		else if (item.part == kTitleText) {
+			p.setFont(_titleFont);
+			p.setPen(_theme.titleColor.isValid() ? _theme.titleColor : palette().color(QPalette::WindowText));
+			const QString text = QFontMetrics(_titleFont).elidedText(_title, Qt::ElideRight, item.rect.width());
+			p.drawText(item.rect, Qt::AlignLeft | Qt::AlignVCenter, text);
+		}
+		else if (item.part & kButtonParts) {
+			QColor color;
+			if (item.part == _pressedPart && item.part == _hoveredPart) {
+				color = _theme.buttonPressedColor.isValid() 
+					? _theme.buttonPressedColor : palette().color(QPalette::Mid);
+			}
+			else if (item.part == _hoveredPart && _pressedPart == 0) {
+				if (item.part == kCloseButton && _theme.closeHoverColor.isValid()) {
+					color = _theme.closeHoverColor;
+				}
+				else {
+					color = _theme.buttonHoverColor.isValid() 
+						? _theme.buttonHoverColor : palette().color(QPalette::Midlight);
+				}
+			}
+			if (color.isValid()) {
+				p.fillRect(item.rect, color);
+			}
+			// the glyph keeps the theme's size, the button only frames it;
+			QRect glyphRect(0, 0, _theme.glyphSize, _theme.glyphSize);
+			glyphRect.moveCenter(item.rect.center());
+			item.glyph.paint(&p, glyphRect, Qt::AlignCenter,
+				item.part == _hoveredPart ? QIcon::Active : QIcon::Normal);
+		}
+	}
+}
+
+void LightCaptionWidget::resizeEvent(QResizeEvent *event)
+{
+	QWidget::resizeEvent(event);
+	relayout();
+}
+
+int LightCaptionWidget::indexOfPart(const int part) const {
+	for (int i = 0; i < _items.size(); ++i) {
+		if (_items[i].part == part) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+int LightCaptionWidget::buttonAt(const QPoint &pos) const {
+	for (const Item &item : _items) {
+		if ((item.part & kButtonParts) && item.visible && item.rect.contains(pos)) {
+			return item.part;
+		}
+	}
+	return 0;
+}
+
+int LightCaptionWidget::itemWidth(const Item &item) const {
+	if (item.part == 0) {
+		if (!item.widget || item.widget->isHidden()) {
+			return 0;
+		}
+		return qBound(item.widget->minimumWidth(), item.widget->sizeHint().width(),
+			item.widget->maximumWidth());
+	}
+	if (!item.visible) {
+		return 0;
+	}
+	switch (item.part) {
+	case kIcon:
+		return kIconWidth;
+	case kTitleText:
+#if QT_VERSION >= QT_VERSION_CHECK(5, 11, 0)
+		return QFontMetrics(_titleFont).horizontalAdvance(_title);
+#else
+		return QFontMetrics(_titleFont).width(_title);
+#endif
+	case kMoreButton:
+		return kMoreButtonWidth;
+	case kMinimizeButton:
+	case kMaximizeButton:
+	case kCloseButton:
+		return _theme.buttonWidth;
+	case kLeftSpacer:
+	case kRightSpacer:
+		return item.spacerSize.width();
+	default:
+		return 0;
+	}
+}
+
+/*
+	Works like the QHBoxLayout of CaptionWidget: fixed items keep their width,
+	extra room goes to stretched widgets, or else to the two spacers, and the
+	title is elided when there is too little room;
+*/
+void LightCaptionWidget::relayout() {
+	const int count = _items.size();
+	QVector<int> widths(count);
+	int used = 0;
+	int stretch = 0;
+	int spacers = 0;
+	for (int i = 0; i < count; ++i) {
+		const Item &item = _items[i];
+		widths[i] = itemWidth(item);
+		used += widths[i];
+		if (item.part == 0 && widths[i] > 0) {
+			stretch += qMax(0, item.stretch);
+		}
+		if ((item.part == kLeftSpacer || item.part == kRightSpacer) && item.visible) {
+			++spacers;
+		}
+	}
+
+	int room = width() - used;
+	const int title = indexOfPart(kTitleText);
+	if (room < 0 && title >= 0) {
+		const int shrink = qMin(widths[title], -room);
+		widths[title] -= shrink;
+		room += shrink;
+	}
+	if (room > 0) {
+		int left = room;
+		for (int i = 0; i < count && left > 0; ++i) {
+			const Item &item = _items[i];
+			int extra = 0;
+			if (stretch > 0) {
+				extra = item.part == 0 && widths[i] > 0 ? room * qMax(0, item.stretch) / stretch : 0;
+			}
+			else if ((item.part == kLeftSpacer || item.part == kRightSpacer) && item.visible) {
+				extra = room / spacers;
+			}
+			extra = qMin(extra, left);
+			widths[i] += extra;
+			left -= extra;
+		}
+	}
+
+	const int h = height();
+	int x = 0;
+	for (int i = 0; i < count; ++i) {
+		Item &item = _items[i];
+		int itemHeight = h;
+		switch (item.part) {
+		case kMoreButton:
+			itemHeight = kMoreButtonHeight;
+			break;
+		case kMinimizeButton:
+		case kMaximizeButton:
+		case kCloseButton:
+			itemHeight = _theme.buttonHeight;
+			break;
+		case 0:
+			if (item.widget) {
+				itemHeight = qBound(item.widget->minimumHeight(), 
+					qMin(item.widget->sizeHint().height(), h), item.widget->maximumHeight());
+			}
+			break;
+		default:
+			break;
+		}
+
+		int y = (h - itemHeight) / 2;
+		if (item.part == 0 && (item.alignment & Qt::AlignTop)) {
+			y = 0;
+		}
+		else if (item.part == 0 && (item.alignment & Qt::AlignBottom)) {
+			y = h - itemHeight;
+		}
+		item.rect = QRect(x, y, widths[i], itemHeight);
+		if (item.part == 0 && item.widget && !item.widget->isHidden()) {
+			item.widget->setGeometry(item.rect);
+		}
+		x += widths[i];
+	}
+
+	// relayout() also runs on every resize, only a new hint concerns the parent;
+	const QSize hint = sizeHint();
+	if (hint != _sizeHint) {
+		_sizeHint = hint;
+		updateGeometry();
+	}
+	update();
+}
+
+void LightCaptionWidget::updateTitleFont() {
+	_titleFont = font();
+	_titleFont.setPixelSize(_theme.titlePixelSize);
+	_titleFont.setBold(_theme.titleBold);
+}
+
+void LightCaptionWidget::setPartVisible(const int part, bool b) {
+	const int index = indexOfPart(part);
+	if (index < 0 || _items[index].visible == b) {
+		return;
+	}
+	_items[index].visible = b;
+	if (!b && (_hoveredPart == part || _pressedPart == part)) {
+		_hoveredPart = 0;
+		_pressedPart = 0;
+	}
+	relayout();
+}
+
+void LightCaptionWidget::trigger(const int part) {
+	switch (part) {
+	case kMoreButton: {
+		const QRect r = _items[indexOfPart(kMoreButton)].rect;
+		const QPoint pos_ = r.topLeft() + QPoint(0, r.height());
+		emit moreClicked(pos_, this->mapToGlobal(pos_));
+		break;
+	}
+	case kMinimizeButton:
+		emit minimizeClicked();
+		break;
+	case kMaximizeButton:
+		emit maximizeClicked();
+		break;
+	case kCloseButton:
+		emit closed();
+		break;
+	default:
+		break;
+	}
+}
@@ -0,0 +1,109 @@
+#ifndef LIGHTCAPTIONWIDGET_H
+#define LIGHTCAPTIONWIDGET_H
+
+#ifdef X_FRAMELESS_WIDGET_SHARED
+#define X_FRAMELESS_WIDGET_EXPORT Q_DECL_EXPORT
+#else
+#define X_FRAMELESS_WIDGET_EXPORT Q_DECL_IMPORT
+#endif
+
+#include "captionitf.h"
+
+#include <QtCore/QPoint>
+#include <QtCore/QPointer>
+#include <QtCore/QVector>
+#include <QtGui/QFont>
+#include <QtGui/QPixmap>
+#include <QtWidgets/QWidget>
+
+/*!
+    \class LightCaptionWidget
+    \brief A caption that lays out, paints and hit-tests icon, title and 
+	buttons itself.
+
+	It has the same parts, indices and signals as CaptionWidget but no layout
+	and no child widgets of its own, which saves six widgets and a layout per
+	window. Only widgets added with insertWidget become children.
+*/
+class X_FRAMELESS_WIDGET_EXPORT LightCaptionWidget : public QWidget, public CaptionIterface {
+	Q_OBJECT
+
+public:
+	LightCaptionWidget(QWidget * parent = Q_NULLPTR);
+	~LightCaptionWidget();
+
+	QWidget* widget() override;
+	void showIcon(bool b) override;
+	void setIcon(const QPixmap& pixmap) override;
+	void showTitleText(bool b) override;
+	void setTitleText(const QString& text) override;
+	void insertWidget(int index, QWidget *widget, int stretch = 0,
+		Qt::Alignment alignment = Qt::Alignment()) override;
+	int indexOfLogo() const override;
+	int indexOfTitleText() const override;
+	int indexOfMoreButton() const override;
+	int indexOfWidget(QWidget * const wgt) const override;
+	void showMoreButton(bool b) override;
+	void showMinimizeButton(bool b) override;
+	void showMaximizeButton(bool b) override;
+	void showCloseButton(bool b) override;
+	void changeLeftSpacerSize(const int w, const int h) override;
+	void changeRightSpacerSize(const int w, const int h) override;
+	int visibleParts() const override;
+	void setVisibleParts(const int parts) override;
+	CaptionTheme theme() const override;
+	void setTheme(const CaptionTheme &theme) override;
+	bool isDragArea(const QPoint &pos) const override;
+
+	QSize sizeHint() const override;
+
+	Q_SIGNAL void moreClicked(const QPoint& wgtPos, const QPoint& globalPos);
+	Q_SIGNAL void minimizeClicked();
+	Q_SIGNAL void maximizeClicked();
+	Q_SIGNAL void closed();
+	// the window takes it as its icon;
+	Q_SIGNAL void iconChanged(const QPixmap& pixmap);
+
+protected:
+	bool event(QEvent *event) override;
+	bool eventFilter(QObject *watched, QEvent *event) override;
+	void leaveEvent(QEvent *event) override;
+	void mouseMoveEvent(QMouseEvent *event) override;
+	void mousePressEvent(QMouseEvent *event) override;
+	void mouseReleaseEvent(QMouseEvent *event) override;
+	void paintEvent(QPaintEvent *event) override;
+	void resizeEvent(QResizeEvent *event) override;
+
+private:
+	struct Item
+	{
+		// a Part, a spacer or 0 for an inserted widget;
+		int part = 0;
+		bool visible = true;
+		QPointer<QWidget> widget;
+		int stretch = 0;
+		Qt::Alignment alignment;
+		QSize spacerSize;
+		QIcon glyph;
+		QRect rect;
+	};
+
+	QVector<Item> _items;
+	QPixmap _icon;
+	QString _title;
+	QFont _titleFont;
+	CaptionTheme _theme;
+	// last size hint the parent layout was told about;
+	QSize _sizeHint;
+	int _hoveredPart = 0;
+	int _pressedPart = 0;
+
+	int indexOfPart(const int part) const;
+	int buttonAt(const QPoint &pos) const;
+	int itemWidth(const Item &item) const;
+	void relayout();
+	void setPartVisible(const int part, bool b);
+	void trigger(const int part);
+	void updateTitleFont();
+};
+#endif
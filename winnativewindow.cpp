@@ -7,9 +7,10 @@
 
 #include "QtCore/QDebug"
 #include "QtWidgets/QApplication"
-#include "QtWidgets/QDesktopWidget"
 #include "QtWidgets/QWidget"
 
+#include "xframelesscontext.h"
+
 namespace
 {
 	struct Context {
@@ -212,11 +213,20 @@ namespace
 			MINMAXINFO* minMaxInfo = reinterpret_cast<MINMAXINFO*>(lParam);
 			if (!nativeWinContext->maximumSize.isEmpty())
 			{
-				QPoint targetTopLeft = qApp->desktop()->availableGeometry().center() - 
-					QPoint(nativeWinContext->maximumSize.width() / 2, 
-					nativeWinContext->maximumSize.height() / 2);
-				minMaxInfo->ptMaxPosition.x = targetTopLeft.x();
-				minMaxInfo->ptMaxPosition.y = targetTopLeft.y();
+				// ptMaxPosition is relative to the monitor the window is on;
+				XFramelessContext *ctx = XFramelessContext::instance();
+				const XFramelessScreenModel::Screen *screen = ctx 
+					? ctx->screens().screenOf(nativeWinContext->childWidget) : Q_NULLPTR;
+				if (screen)
+				{
+					const QPoint center = (screen->availableGeometry.center() 
+						- screen->geometry.topLeft()) * screen->devicePixelRatio;
+					QPoint targetTopLeft = center - 
+						QPoint(nativeWinContext->maximumSize.width() / 2, 
+						nativeWinContext->maximumSize.height() / 2);
+					minMaxInfo->ptMaxPosition.x = targetTopLeft.x();
+					minMaxInfo->ptMaxPosition.y = targetTopLeft.y();
+				}
 				minMaxInfo->ptMaxTrackSize.x = nativeWinContext->maximumSize.width();
 				minMaxInfo->ptMaxTrackSize.y = nativeWinContext->maximumSize.height();
 			}
@@ -0,0 +1,331 @@
+#include "xframelessbackend_linux.h"
+
+#include "QtCore/QHash"
+#include "QtGui/QGuiApplication"
+#include "QtWidgets/QWidget"
+
+#include "xframelesscontext.h"
+
+namespace xutils_linux
+{
+
+namespace
+{
+
+class X11Backend final : public Backend
+{
+public:
+	void beginBatch() override
+	{
+		BeginBatch();
+	}
+
+	void endBatch() override
+	{
+		EndBatch();
+	}
+
+	void setWindowExtents(const QWidget *w, const QMargins &margins, int resizeHandleWidth) override
+	{
+		SetWindowExtents(w, margins, resizeHandleWidth);
+	}
+
+	void setBypassCompositor(const QWidget *w, bool on) override
+	{
+		SetBypassCompositor(w, on);
+	}
+
+	void setExternalShadow(const QWidget *w, int radius, const QColor &color) override
+	{
+		if (radius <= 0) {
+			RemoveExternalShadow(w);
+			return;
+		}
+		XFramelessContext *context = XFramelessContext::instance();
+		if (!context || !IsExternalShadowSupported()) {
+			return;
+		}
+		if (const unsigned long *tiles = context->shadowTiles(radius, color)) {
+			SetExternalShadow(w, tiles, radius);
+		}
+	}
+
+	void setBoundingShape(const QWidget *w, const QRect &rect) override
+	{
+		SetBoundingShape(w->winId(), rect);
+	}
+
+	void setNetWmStateProperty(const QWidget *w, int states) override
+	{
+		SetNetWmStateProperty(w, states);
+	}
+
+	void changeNetWmStates(const QWidget *w, int add, int remove) override
+	{
+		ChangeNetWmStates(w, add, remove);
+	}
+
+	void showMinimizedWindow(const QWidget *w) override
+	{
+		ShowMinimizedWindow(w, true);
+	}
+
+	bool confirmsWindowStates() override
+	{
+		return true;
+	}
+
+	int netWmStates(const QWidget *w) override
+	{
+		return GetNetWmStates(w);
+	}
+
+	void requestSyncNotify(const QWidget *w) override
+	{
+		RequestSyncNotify(w);
+	}
+
+	void createEdgeWindows(const QWidget *w, unsigned long *ids) override
+	{
+		CreateEdgeWindows(w, ids);
+	}
+
+	void updateEdgeWindows(const unsigned long *ids, const QRect &windowRect,
+		const QMargins &margins, int resizeHandleWidth) override
+	{
+		UpdateEdgeWindows(ids, windowRect, margins, resizeHandleWidth);
+	}
+
+	void destroyEdgeWindows(unsigned long *ids) override
+	{
+		DestroyEdgeWindows(ids);
+	}
+
+	void updateCursorShape(const QWidget *w, int x, int y, const QMargins &margins,
+		int resizeHandleWidth) override
+	{
+		UpdateCursorShape(w, x, y, margins, resizeHandleWidth);
+	}
+
+	bool isMoveResizeSupported() override
+	{
+		return IsMoveResizeSupported();
+	}
+
+	void sendButtonRelease(const QWidget *w, const QPoint &pos, const QPoint &globalPos) override
+	{
+		SendButtonRelease(w, pos, globalPos);
+	}
+
+	void startMove(const QWidget *w, Qt::MouseButton button, const QPoint &rootPos,
+		unsigned long timestamp) override
+	{
+		MoveWindow(w, button, rootPos, timestamp);
+	}
+
+	void startResize(const QWidget *w, const QPoint &rootPos, const CornerEdge &ce,
+		unsigned long timestamp) override
+	{
+		StartResizing(w, rootPos, ce, timestamp);
+	}
+
+	void moveResizeWindowTo(QWidget *w, const QRect &rect) override
+	{
+		// Qt maps to device pixels per screen and keeps its geometry current;
+		w->setGeometry(rect);
+	}
+};
+
+// QVariant has no QMargins type;
+QVariant marginsArg(const QMargins &margins)
+{
+	return QVariantList({ margins.left(), margins.top(), margins.right(), margins.bottom() });
+}
+
+// edge window ids are keys of the context's native event handlers, so
+// they have to be unique across windows;
+unsigned long nextHeadlessId = 1;
+
+QHash<const QWidget *, HeadlessBackend *> &headlessBackends()
+{
+	static QHash<const QWidget *, HeadlessBackend *> backends;
+	return backends;
+}
+
+}
+
+Backend *Backend::create(const QWidget *widget)
+{
+	if (QGuiApplication::platformName() == QLatin1String("offscreen")) {
+		return new HeadlessBackend(widget);
+	}
+	if (IsPlatformX11()) {
+		return new X11Backend();
+	}
+	return Q_NULLPTR;
+}
+
+HeadlessBackend::HeadlessBackend(const QWidget *widget)
+	: _widget(widget)
+{
+	headlessBackends().insert(_widget, this);
+}
+
+HeadlessBackend::~HeadlessBackend()
+{
+	headlessBackends().remove(_widget);
+}
+
+HeadlessBackend *HeadlessBackend::forWidget(const QWidget *widget)
+{
+	return headlessBackends().value(widget);
+}
+
+const QVector<HeadlessBackend::Operation> &HeadlessBackend::operations() const
+{
+	return _operations;
+}
+
+int HeadlessBackend::count(const QByteArray &name) const
+{
+	int n = 0;
+	for (const Operation &op : _operations) {
+		n += op.name == name ? 1 : 0;
+	}
+	return n;
+}
+
+void HeadlessBackend::clear()
+{
+	_operations.clear();
+}
+
+void HeadlessBackend::record(const char *name, WId window, const QVariantList &args)
+{
+	_operations.append({ QByteArray(name), window, args });
+}
+
+void HeadlessBackend::beginBatch()
+{
+	record("beginBatch", 0);
+}
+
+void HeadlessBackend::endBatch()
+{
+	record("endBatch", 0);
+}
+
+void HeadlessBackend::setWindowExtents(const QWidget *w, const QMargins &margins,
+	int resizeHandleWidth)
+{
+	record("setWindowExtents", w->internalWinId(), { w->rect(), marginsArg(margins),
+		resizeHandleWidth });
+}
+
+void HeadlessBackend::setBypassCompositor(const QWidget *w, bool on)
+{
+	record("setBypassCompositor", w->internalWinId(), { on });
+}
+
+void HeadlessBackend::setExternalShadow(const QWidget *w, int radius, const QColor &color)
+{
+	record("setExternalShadow", w->internalWinId(), { radius, static_cast<uint>(color.rgba()) });
+}
+
+void HeadlessBackend::setBoundingShape(const QWidget *w, const QRect &rect)
+{
+	record("setBoundingShape", w->internalWinId(), { rect });
+}
+
+void HeadlessBackend::setNetWmStateProperty(const QWidget *w, int states)
+{
+	record("setNetWmStateProperty", w->internalWinId(), { states });
+}
+
+void HeadlessBackend::changeNetWmStates(const QWidget *w, int add, int remove)
+{
+	record("changeNetWmStates", w->internalWinId(), { add, remove });
+}
+
+void HeadlessBackend::showMinimizedWindow(const QWidget *w)
+{
+	record("showMinimizedWindow", w->internalWinId());
+}
+
+bool HeadlessBackend::confirmsWindowStates()
+{
+	return false;
+}
+
+int HeadlessBackend::netWmStates(const QWidget *w)
+{
+	record("netWmStates", w->internalWinId());
+	return 0;
+}
+
+void HeadlessBackend::requestSyncNotify(const QWidget *w)
+{
+	record("requestSyncNotify", w->internalWinId());
+}
+
+void HeadlessBackend::createEdgeWindows(const QWidget *w, unsigned long *ids)
+{
+	for (int i = 0; i < kEdgeWindowCount; ++i) {
+		ids[i] = nextHeadlessId++;
+	}
+	record("createEdgeWindows", w->internalWinId());
+}
+
+void HeadlessBackend::updateEdgeWindows(const unsigned long *ids, const QRect &windowRect,
+	const QMargins &margins, int resizeHandleWidth)
+{
+	Q_UNUSED(ids);
+	record("updateEdgeWindows", _widget->internalWinId(), { windowRect,
+		marginsArg(margins), resizeHandleWidth });
+}
+
+void HeadlessBackend::destroyEdgeWindows(unsigned long *ids)
+{
+	for (int i = 0; i < kEdgeWindowCount; ++i) {
+		ids[i] = 0;
+	}
+	record("destroyEdgeWindows", _widget->internalWinId());
+}
+
+void HeadlessBackend::updateCursorShape(const QWidget *w, int x, int y, const QMargins &margins,
+	int resizeHandleWidth)
+{
+	const CornerEdge ce = GetCornerEdge(w, x, y, margins, resizeHandleWidth);
+	record("updateCursorShape", w->internalWinId(), { static_cast<int>(ce) });
+}
+
+bool HeadlessBackend::isMoveResizeSupported()
+{
+	return true;
+}
+
+void HeadlessBackend::sendButtonRelease(const QWidget *w, const QPoint &pos, const QPoint &globalPos)
+{
+	record("sendButtonRelease", w->internalWinId(), { pos, globalPos });
+}
+
+void HeadlessBackend::startMove(const QWidget *w, Qt::MouseButton button, const QPoint &rootPos,
+	unsigned long timestamp)
+{
+	record("startMove", w->internalWinId(), { static_cast<int>(button), rootPos,
+		static_cast<qulonglong>(timestamp) });
+}
+
+void HeadlessBackend::startResize(const QWidget *w, const QPoint &rootPos, const CornerEdge &ce,
+	unsigned long timestamp)
+{
+	record("startResize", w->internalWinId(), { rootPos, static_cast<int>(ce),
+		static_cast<qulonglong>(timestamp) });
+}
+
+void HeadlessBackend::moveResizeWindowTo(QWidget *w, const QRect &rect)
+{
+	record("moveResizeWindowTo", w->internalWinId(), { rect });
+}
+
+}
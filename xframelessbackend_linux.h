@@ -0,0 +1,144 @@
+#ifndef XFRAMELESSBACKEND_LINUX_H
+#define XFRAMELESSBACKEND_LINUX_H
+
+#ifdef X_FRAMELESS_WIDGET_SHARED
+#define X_FRAMELESS_WIDGET_EXPORT Q_DECL_EXPORT
+#else
+#define X_FRAMELESS_WIDGET_EXPORT Q_DECL_IMPORT
+#endif
+
+#include "xutil_linux.h"
+
+#include "QtCore/QByteArray"
+#include "QtCore/QMargins"
+#include "QtCore/QPoint"
+#include "QtCore/QRect"
+#include "QtCore/QVariant"
+#include "QtCore/QVector"
+#include "QtGui/QColor"
+#include "QtGui/qwindowdefs.h"
+
+namespace xutils_linux
+{
+
+/*!
+ * The native operations XFramelessWidget performs on Linux. X11Backend
+ * sends them to the X server, HeadlessBackend only records them, so the
+ * widget logic (caption, layout, hit testing, state bookkeeping) runs the
+ * same code paths under the offscreen platform plugin, without a display
+ * server.
+ */
+class Backend
+{
+public:
+	virtual ~Backend() {}
+
+	// HeadlessBackend under the offscreen plugin, X11Backend on xcb,
+	// null elsewhere (e.g. Wayland), where Qt alone does the work;
+	static Backend *create(const QWidget *widget);
+
+	virtual void beginBatch() = 0;
+	virtual void endBatch() = 0;
+
+	virtual void setWindowExtents(const QWidget *w, const QMargins &margins, int resizeHandleWidth) = 0;
+	virtual void setBypassCompositor(const QWidget *w, bool on) = 0;
+	// shadow drawn by the compositor outside the window, a radius of 0
+	// removes it; nothing happens where the compositor has no support;
+	virtual void setExternalShadow(const QWidget *w, int radius, const QColor &color) = 0;
+	// clips the window to rect, an empty rect removes the shape;
+	virtual void setBoundingShape(const QWidget *w, const QRect &rect) = 0;
+
+	virtual void setNetWmStateProperty(const QWidget *w, int states) = 0;
+	virtual void changeNetWmStates(const QWidget *w, int add, int remove) = 0;
+	virtual void showMinimizedWindow(const QWidget *w) = 0;
+	// whether the WM confirms state changes through _NET_WM_STATE property
+	// notifies; headless, Qt applies them right away;
+	virtual bool confirmsWindowStates() = 0;
+	virtual int netWmStates(const QWidget *w) = 0;
+	virtual void requestSyncNotify(const QWidget *w) = 0;
+
+	virtual void createEdgeWindows(const QWidget *w, unsigned long *ids) = 0;
+	virtual void updateEdgeWindows(const unsigned long *ids, const QRect &windowRect,
+		const QMargins &margins, int resizeHandleWidth) = 0;
+	virtual void destroyEdgeWindows(unsigned long *ids) = 0;
+	virtual void updateCursorShape(const QWidget *w, int x, int y, const QMargins &margins,
+		int resizeHandleWidth) = 0;
+
+	virtual bool isMoveResizeSupported() = 0;
+	virtual void sendButtonRelease(const QWidget *w, const QPoint &pos, const QPoint &globalPos) = 0;
+	// rootPos and timestamp are those of the event starting the operation;
+	virtual void startMove(const QWidget *w, Qt::MouseButton button, const QPoint &rootPos,
+		unsigned long timestamp) = 0;
+	virtual void startResize(const QWidget *w, const QPoint &rootPos, const CornerEdge &ce,
+		unsigned long timestamp) = 0;
+	// rect is in logical coordinates, like QWidget::geometry();
+	virtual void moveResizeWindowTo(QWidget *w, const QRect &rect) = 0;
+};
+
+/*!
+ * Records every native operation instead of performing it. Use forWidget()
+ * to inspect what a window would have sent, e.g. to count requests per
+ * window in a benchmark.
+ */
+class X_FRAMELESS_WIDGET_EXPORT HeadlessBackend final : public Backend
+{
+public:
+	struct Operation
+	{
+		QByteArray name;
+		WId window;
+		QVariantList args;
+	};
+
+	explicit HeadlessBackend(const QWidget *widget);
+	~HeadlessBackend();
+
+	// the backend of an XFramelessWidget running headless, or null;
+	static HeadlessBackend *forWidget(const QWidget *widget);
+
+	const QVector<Operation> &operations() const;
+	int count(const QByteArray &name) const;
+	void clear();
+
+	void beginBatch() override;
+	void endBatch() override;
+
+	void setWindowExtents(const QWidget *w, const QMargins &margins, int resizeHandleWidth) override;
+	void setBypassCompositor(const QWidget *w, bool on) override;
+	void setExternalShadow(const QWidget *w, int radius, const QColor &color) override;
+	void setBoundingShape(const QWidget *w, const QRect &rect) override;
+
+	void setNetWmStateProperty(const QWidget *w, int states) override;
+	void changeNetWmStates(const QWidget *w, int add, int remove) override;
+	void showMinimizedWindow(const QWidget *w) override;
+	bool confirmsWindowStates() override;
+	int netWmStates(const QWidget *w) override;
+	void requestSyncNotify(const QWidget *w) override;
+
+	void createEdgeWindows(const QWidget *w, unsigned long *ids) override;
+	void updateEdgeWindows(const unsigned long *ids, const QRect &windowRect,
+		const QMargins &margins, int resizeHandleWidth) override;
+	void destroyEdgeWindows(unsigned long *ids) override;
+	void updateCursorShape(const QWidget *w, int x, int y, const QMargins &margins,
+		int resizeHandleWidth) override;
+
+	bool isMoveResizeSupported() override;
+	void sendButtonRelease(const QWidget *w, const QPoint &pos, const QPoint &globalPos) override;
+	void startMove(const QWidget *w, Qt::MouseButton button, const QPoint &rootPos,
+		unsigned long timestamp) override;
+	void startResize(const QWidget *w, const QPoint &rootPos, const CornerEdge &ce,
+		unsigned long timestamp) override;
+	void moveResizeWindowTo(QWidget *w, const QRect &rect) override;
+
+private:
+	Q_DISABLE_COPY(HeadlessBackend)
+
+	void record(const char *name, WId window, const QVariantList &args = QVariantList());
+
+	const QWidget *_widget;
+	QVector<Operation> _operations;
+};
+
+}
+
+#endif // XFRAMELESSBACKEND_LINUX_H
@@ -0,0 +1,350 @@
+#include "xframelesscontext.h"
+
+#include "QtCore/QDebug"
+
+#if defined(Q_OS_LINUX)
+#include "QtCore/QAbstractNativeEventFilter"
+#include "QtCore/QCoreApplication"
+#include "QtX11Extras/QX11Info"
+
+#include "xutil_linux.h"
+
+#include <X11/Xlib.h>
+#include <xcb/xcb.h>
+
+// xcb_xfixes_selection_notify_event_t, which would need the xcb-xfixes
+// headers Qt does not install;
+struct XFixesSelectionNotifyWire
+{
+	uint8_t response_type;
+	uint8_t subtype;
+	uint16_t sequence;
+	uint32_t window;
+	uint32_t owner;
+	uint32_t selection;
+	uint32_t timestamp;
+	uint32_t selection_timestamp;
+	uint8_t pad0[8];
+};
+
+class XFramelessNativeEventFilter final : public QAbstractNativeEventFilter
+{
+public:
+	explicit XFramelessNativeEventFilter(XFramelessContext *ctx)
+		: _ctx(ctx)
+	{
+	}
+
+	bool nativeEventFilter(const QByteArray &eventType, void *message, long *result) override
+	{
+		Q_UNUSED(result);
+		if (eventType != "xcb_generic_event_t")
+		{
+			return false;
+		}
+		return _ctx->dispatchNativeEvent(message);
+	}
+
+private:
+	XFramelessContext *_ctx;
+};
+#endif
+
+XFramelessContext *XFramelessContext::_self = Q_NULLPTR;
+
+XFramelessContext::Ref::Ref()
+	: _ctx(XFramelessContext::acquire())
+{
+}
+
+XFramelessContext::Ref::~Ref()
+{
+	XFramelessContext::release();
+}
+
+XFramelessContext::XFramelessContext()
+	: _refCount(0)
+{
+	qDebug() << "XFramelessContext()";
+}
+
+XFramelessContext::~XFramelessContext()
+{
+#if defined(Q_OS_LINUX)
+	if (_nativeEventFilter)
+	{
+		if (QCoreApplication::instance())
+		{
+			QCoreApplication::instance()->removeNativeEventFilter(_nativeEventFilter);
+		}
+		delete _nativeEventFilter;
+	}
+
+	// cursors and shadow tiles are server side resources, the atoms are not;
+	const auto display = QX11Info::display();
+	if (display)
+	{
+		for (const unsigned long cursor : qAsConst(_cursors))
+		{
+			XFreeCursor(display, cursor);
+		}
+		for (const QVector<unsigned long> &tiles : qAsConst(_shadowTiles))
+		{
+			if (!tiles.isEmpty())
+			{
+				xutils_linux::FreeShadowTiles(tiles.constData());
+			}
+		}
+	}
+#endif
+	qDebug() << "~XFramelessContext()";
+}
+
+XFramelessContext *XFramelessContext::acquire()
+{
+	if (!_self)
+	{
+		_self = new XFramelessContext();
+	}
+	++_self->_refCount;
+	return _self;
+}
+
+void XFramelessContext::release()
+{
+	Q_ASSERT(_self && _self->_refCount > 0);
+	if (--_self->_refCount == 0)
+	{
+		delete _self;
+		_self = Q_NULLPTR;
+	}
+}
+
+XFramelessContext *XFramelessContext::instance()
+{
+	return _self;
+}
+
+int XFramelessContext::refCount() const
+{
+	return _refCount;
+}
+
+XFramelessScreenModel &XFramelessContext::screens()
+{
+	return _screens;
+}
+
+#if defined(Q_OS_LINUX)
+
+unsigned long XFramelessContext::atom(const char *name)
+{
+	const QByteArray key(name);
+	auto it = _atoms.constFind(key);
+	if (it != _atoms.constEnd())
+	{
+		return it.value();
+	}
+
+	const Atom atom = XInternAtom(QX11Info::display(), name, False);
+	if (atom != None)
+	{
+		_atoms.insert(key, atom);
+	}
+	return atom;
+}
+
+unsigned long XFramelessContext::fontCursor(unsigned int shape)
+{
+	auto it = _cursors.constFind(shape);
+	if (it != _cursors.constEnd())
+	{
+		return it.value();
+	}
+
+	const Cursor cursor = XCreateFontCursor(QX11Info::display(), shape);
+	if (cursor != None)
+	{
+		_cursors.insert(shape, cursor);
+	}
+	return cursor;
+}
+
+bool XFramelessContext::hasNetSupported() const
+{
+	return _hasNetSupported;
+}
+
+const QVector<unsigned long> &XFramelessContext::netSupported() const
+{
+	return _netSupported;
+}
+
+void XFramelessContext::setNetSupported(const QVector<unsigned long> &atoms)
+{
+	_netSupported = atoms;
+	_hasNetSupported = true;
+}
+
+void XFramelessContext::watchNetSupported()
+{
+	if (_rootWindow)
+	{
+		return;
+	}
+	installNativeEventFilter();
+	_rootWindow = xutils_linux::SelectRootPropertyChanges();
+}
+
+void XFramelessContext::setNetSupportedHandler(const void *owner, const NetSupportedHandler &handler)
+{
+	_netSupportedHandlers.insert(owner, handler);
+}
+
+void XFramelessContext::removeNetSupportedHandler(const void *owner)
+{
+	_netSupportedHandlers.remove(owner);
+}
+
+void XFramelessContext::installNativeEventFilter()
+{
+	if (!_nativeEventFilter && QCoreApplication::instance())
+	{
+		_nativeEventFilter = new XFramelessNativeEventFilter(this);
+		QCoreApplication::instance()->installNativeEventFilter(_nativeEventFilter);
+	}
+}
+
+void XFramelessContext::setNativeEventHandler(unsigned long window, const NativeEventHandler &handler)
+{
+	installNativeEventFilter();
+	_nativeEventHandlers.insert(window, handler);
+}
+
+void XFramelessContext::removeNativeEventHandler(unsigned long window)
+{
+	_nativeEventHandlers.remove(window);
+}
+
+const unsigned long *XFramelessContext::shadowTiles(int radius, const QColor &color)
+{
+	const QPair<int, QRgb> key(radius, color.rgba());
+	auto it = _shadowTiles.find(key);
+	if (it == _shadowTiles.end())
+	{
+		QVector<unsigned long> tiles(xutils_linux::kShadowTileCount);
+		if (!xutils_linux::CreateShadowTiles(radius, color, tiles.data()))
+		{
+			tiles.clear();
+		}
+		it = _shadowTiles.insert(key, tiles);
+	}
+	return it->isEmpty() ? Q_NULLPTR : it->constData();
+}
+
+bool XFramelessContext::isCompositing()
+{
+	if (_compositing < 0)
+	{
+		if (!xutils_linux::IsPlatformX11())
+		{
+			_compositing = 0;
+			return false;
+		}
+		installNativeEventFilter();
+		_compositing = xutils_linux::WatchCompositingManager(&_compositingSelection,
+			&_compositingEventType) ? 1 : 0;
+	}
+	return _compositing > 0;
+}
+
+void XFramelessContext::setCompositingHandler(const void *owner, const CompositingHandler &handler)
+{
+	_compositingHandlers.insert(owner, handler);
+}
+
+void XFramelessContext::removeCompositingHandler(const void *owner)
+{
+	_compositingHandlers.remove(owner);
+}
+
+void XFramelessContext::setCompositing(bool compositing)
+{
+	if (_compositing == (compositing ? 1 : 0))
+	{
+		return;
+	}
+	_compositing = compositing ? 1 : 0;
+
+	// a handler may unregister itself;
+	const QList<CompositingHandler> handlers = _compositingHandlers.values();
+	for (const CompositingHandler &handler : handlers)
+	{
+		handler(compositing);
+	}
+}
+
+bool XFramelessContext::dispatchNativeEvent(void *event)
+{
+	const auto ev = static_cast<xcb_generic_event_t *>(event);
+	if (_compositingEventType >= 0 && (ev->response_type & ~0x80) == _compositingEventType)
+	{
+		const auto notify = reinterpret_cast<const XFixesSelectionNotifyWire *>(ev);
+		if (notify->selection == _compositingSelection)
+		{
+			// no owner after the destroy and client close notifications;
+			setCompositing(notify->owner != XCB_NONE);
+		}
+		// Qt tracks the compositor too;
+		return false;
+	}
+
+	if (_rootWindow && (ev->response_type & ~0x80) == XCB_PROPERTY_NOTIFY)
+	{
+		const auto notify = reinterpret_cast<const xcb_property_notify_event_t *>(ev);
+		// a new WM replaces _NET_SUPPORTING_WM_CHECK, and may keep the list;
+		if (notify->window == _rootWindow && _hasNetSupported
+			&& (notify->atom == atom("_NET_SUPPORTED")
+				|| notify->atom == atom("_NET_SUPPORTING_WM_CHECK")))
+		{
+			_hasNetSupported = false;
+			_netSupported.clear();
+			// a handler may unregister itself;
+			const QList<NetSupportedHandler> handlers = _netSupportedHandlers.values();
+			for (const NetSupportedHandler &handler : handlers)
+			{
+				handler();
+			}
+		}
+		// Qt reads the root properties as well;
+		return false;
+	}
+
+	if (_nativeEventHandlers.isEmpty())
+	{
+		return false;
+	}
+
+	xcb_window_t window = XCB_NONE;
+	switch (ev->response_type & ~0x80)
+	{
+	case XCB_BUTTON_PRESS:
+	case XCB_BUTTON_RELEASE:
+	case XCB_MOTION_NOTIFY:
+		window = reinterpret_cast<xcb_button_press_event_t *>(ev)->event;
+		break;
+	case XCB_PROPERTY_NOTIFY:
+		window = reinterpret_cast<xcb_property_notify_event_t *>(ev)->window;
+		break;
+	case XCB_MAP_NOTIFY:
+		window = reinterpret_cast<xcb_map_notify_event_t *>(ev)->window;
+		break;
+	default:
+		return false;
+	}
+
+	auto it = _nativeEventHandlers.constFind(window);
+	return it != _nativeEventHandlers.constEnd() && it.value()(event);
+}
+
+#endif
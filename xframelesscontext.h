@@ -0,0 +1,140 @@
+#ifndef XFRAMELESSCONTEXT_H
+#define XFRAMELESSCONTEXT_H
+
+#include "QtCore/QHash"
+#include "QtCore/QPair"
+#include "QtCore/QVector"
+#include "QtGui/QColor"
+
+#include <functional>
+
+#include "xframelessscreenmodel.h"
+
+class XFramelessNativeEventFilter;
+
+
+/*!
+ * \internal
+ * Process-wide resources that do not depend on a particular window, shared
+ * by every XFramelessWidget. The context exists while at least one window
+ * holds a XFramelessContext::Ref and is destroyed with the last one.
+ *
+ * Nothing here is cached per screen except the screen model. On Linux the
+ * shadow tiles are keyed by their radius in device pixels, which already
+ * tells screens with different device pixel ratios apart; X has one root
+ * window for all of them, so the tiles need no other screen key.
+ */
+class XFramelessContext final
+{
+public:
+	/*! 
+	 * Lightweight handle each window keeps to the shared context.
+	 */
+	class Ref final
+	{
+	public:
+		Ref();
+		~Ref();
+
+		XFramelessContext *get() const { return _ctx; }
+		XFramelessContext *operator->() const { return _ctx; }
+
+	private:
+		Q_DISABLE_COPY(Ref)
+		XFramelessContext *_ctx;
+	};
+
+	/*! Returns the shared context, or null if no window holds a reference. */
+	static XFramelessContext *instance();
+
+	int refCount() const;
+
+	XFramelessScreenModel &screens();
+
+#if defined(Q_OS_LINUX)
+	unsigned long atom(const char *name);
+	unsigned long fontCursor(unsigned int shape);
+
+	/*!
+	 * Root window _NET_SUPPORTED, read once and dropped again when the
+	 * window manager changes it or is replaced. Call watchNetSupported()
+	 * before reading the property, so no change falls in between; the
+	 * handlers then run on every change.
+	 */
+	bool hasNetSupported() const;
+	const QVector<unsigned long> &netSupported() const;
+	void setNetSupported(const QVector<unsigned long> &atoms);
+	void watchNetSupported();
+	typedef std::function<void()> NetSupportedHandler;
+	void setNetSupportedHandler(const void *owner, const NetSupportedHandler &handler);
+	void removeNetSupportedHandler(const void *owner);
+
+	/*!
+	 * Handlers for native events (xcb_generic_event_t) delivered to X windows
+	 * Qt does not know about, such as the resize edge windows, or property
+	 * and map notifies of a window's own X window. A handler returns true
+	 * to stop Qt from processing the event.
+	 */
+	typedef std::function<bool(void *event)> NativeEventHandler;
+	void setNativeEventHandler(unsigned long window, const NativeEventHandler &handler);
+	void removeNativeEventHandler(unsigned long window);
+
+	/*!
+	 * The eight _KDE_NET_WM_SHADOW tiles for a shadow radius (in device
+	 * pixels) and color, created on first use and shared by every window
+	 * using the same shadow, whatever screen it is on. Null if they cannot
+	 * be created.
+	 */
+	const unsigned long *shadowTiles(int radius, const QColor &color);
+
+	/*!
+	 * Whether a compositing manager owns _NET_WM_CM_S<screen>. The server is
+	 * asked once; from then on XFixes selection owner notifications keep
+	 * the answer current and run the handlers registered for changes.
+	 */
+	bool isCompositing();
+	typedef std::function<void(bool compositing)> CompositingHandler;
+	void setCompositingHandler(const void *owner, const CompositingHandler &handler);
+	void removeCompositingHandler(const void *owner);
+#endif
+
+private:
+	XFramelessContext();
+	~XFramelessContext();
+	Q_DISABLE_COPY(XFramelessContext)
+
+	static XFramelessContext *acquire();
+	static void release();
+
+	static XFramelessContext *_self;
+	int _refCount;
+
+	XFramelessScreenModel _screens;
+
+#if defined(Q_OS_LINUX)
+	QHash<QByteArray, unsigned long> _atoms;
+	QHash<unsigned int, unsigned long> _cursors;
+	bool _hasNetSupported = false;
+	QVector<unsigned long> _netSupported;
+	// 0 until watched;
+	unsigned long _rootWindow = 0;
+	QHash<const void *, NetSupportedHandler> _netSupportedHandlers;
+
+	friend class XFramelessNativeEventFilter;
+	bool dispatchNativeEvent(void *event);
+	void installNativeEventFilter();
+	void setCompositing(bool compositing);
+	QHash<unsigned long, NativeEventHandler> _nativeEventHandlers;
+	XFramelessNativeEventFilter *_nativeEventFilter = Q_NULLPTR;
+	// an empty entry remembers a failure;
+	QHash<QPair<int, QRgb>, QVector<unsigned long> > _shadowTiles;
+
+	// -1 until asked;
+	int _compositing = -1;
+	unsigned long _compositingSelection = 0;
+	int _compositingEventType = -1;
+	QHash<const void *, CompositingHandler> _compositingHandlers;
+#endif
+};
+
+#endif // XFRAMELESSCONTEXT_H
@@ -0,0 +1,255 @@
+#include "xframelessgeometrytransaction.h"
+
+#include "QtCore/QPointer"
+#include "QtCore/QVector"
+
+#if defined(Q_OS_LINUX)
+#include "xutil_linux.h"
+#endif
+
+class XFramelessGeometryTransactionPrivate final
+{
+public:
+	struct Record
+	{
+		QPointer<XFramelessWidget> widget;
+		bool hasPos = false;
+		bool hasSize = false;
+		bool hasMinimumSize = false;
+		bool hasMaximumSize = false;
+		bool hasState = false;
+		QPoint pos;
+		QSize size;
+		QSize minimumSize;
+		QSize maximumSize;
+		Qt::WindowStates state;
+	};
+
+	/*!
+	 * Later changes to the same window overwrite earlier ones, so every
+	 * window is touched at most once per commit.
+	 */
+	Record &record(XFramelessWidget *w)
+	{
+		Q_ASSERT_X(w != Q_NULLPTR, __FUNCTION__, "widget cannt be empty");
+		for (Record &r : _records)
+		{
+			if (r.widget == w)
+			{
+				return r;
+			}
+		}
+		_records.append(Record());
+		_records.last().widget = w;
+		return _records.last();
+	}
+
+	void doCommit()
+	{
+		QVector<QPointer<XFramelessWidget> > touched;
+		for (const Record &r : qAsConst(_records))
+		{
+			if (r.widget && r.widget->updatesEnabled())
+			{
+				r.widget->setUpdatesEnabled(false);
+				touched.append(r.widget);
+			}
+		}
+
+#if defined(Q_OS_LINUX)
+		// only holds back the frame extents, input shape and shadow writes of
+		// this library; Qt configures and flushes every window by itself;
+		xutils_linux::BeginBatch();
+#endif
+		for (const Record &r : qAsConst(_records))
+		{
+			if (r.widget)
+			{
+				apply(r);
+			}
+		}
+#if defined(Q_OS_LINUX)
+		xutils_linux::EndBatch();
+#endif
+
+		for (const auto &w : qAsConst(touched))
+		{
+			if (w)
+			{
+				w->setUpdatesEnabled(true);
+			}
+		}
+		_records.clear();
+	}
+
+	QVector<Record> _records;
+
+private:
+	static void apply(const Record &r)
+	{
+		XFramelessWidget *w = r.widget;
+		if (r.hasMinimumSize)
+		{
+			w->setMinimumSize(r.minimumSize);
+		}
+		if (r.hasMaximumSize)
+		{
+			w->setMaximumSize(r.maximumSize);
+		}
+
+		// Geometry is the normal geometry: restore before applying it, 
+		// and apply it before maximizing/fullscreening/minimizing;
+		const Qt::WindowStates special = Qt::WindowMaximized | Qt::WindowFullScreen 
+			| Qt::WindowMinimized;
+		const bool toNormal = r.hasState && !(r.state & special);
+		if (toNormal)
+		{
+			applyState(w, r.state);
+		}
+		if (r.hasPos && r.hasSize)
+		{
+			w->setGeometry(r.pos.x(), r.pos.y(), r.size.width(), r.size.height());
+		}
+		else if (r.hasPos)
+		{
+			w->setGeometry(r.pos.x(), r.pos.y(), w->width(), w->height());
+		}
+		else if (r.hasSize)
+		{
+			w->resize(r.size);
+		}
+		if (r.hasState && !toNormal)
+		{
+			applyState(w, r.state);
+		}
+	}
+
+	static void applyState(XFramelessWidget *w, Qt::WindowStates state)
+	{
+		if (!w->isVisible())
+		{
+			// takes effect on the first show;
+			w->setWindowState(state);
+		}
+		else if (state & Qt::WindowMinimized)
+		{
+			w->showMinimized();
+		}
+		else if (state & Qt::WindowFullScreen)
+		{
+			w->showFullScreen();
+		}
+		else if (state & Qt::WindowMaximized)
+		{
+			w->showMaximized();
+		}
+		else
+		{
+			w->showNormal();
+		}
+	}
+};
+
+/*!
+	\class XFramelessGeometryTransaction
+	\brief Records geometry, size constraint and window state changes for 
+	one or many XFramelessWidget and applies them on commit().
+
+	Nothing happens until commit(). On commit every window is updated once
+	with painting suspended, e.g. to tile or cascade many windows without
+	repainting each of them per change. Uncommitted changes are dropped on
+	destruction.
+
+	This does not batch the window system requests: Qt configures each
+	window separately, as it is moved or resized, and flushes its own
+	requests, so the windows still move one after the other and may show
+	in between states.
+*/
+XFramelessGeometryTransaction::XFramelessGeometryTransaction()
+	: d_ptr(new XFramelessGeometryTransactionPrivate())
+{
+}
+
+XFramelessGeometryTransaction::~XFramelessGeometryTransaction()
+{
+}
+
+XFramelessGeometryTransaction &XFramelessGeometryTransaction::setGeometry(XFramelessWidget *w,
+	const QRect &rect)
+{
+	Q_D(XFramelessGeometryTransaction);
+	auto &r = d->record(w);
+	r.hasPos = true;
+	r.hasSize = true;
+	r.pos = rect.topLeft();
+	r.size = rect.size();
+	return *this;
+}
+
+XFramelessGeometryTransaction &XFramelessGeometryTransaction::move(XFramelessWidget *w,
+	const QPoint &pos)
+{
+	Q_D(XFramelessGeometryTransaction);
+	auto &r = d->record(w);
+	r.hasPos = true;
+	r.pos = pos;
+	return *this;
+}
+
+XFramelessGeometryTransaction &XFramelessGeometryTransaction::resize(XFramelessWidget *w,
+	const QSize &sz)
+{
+	Q_D(XFramelessGeometryTransaction);
+	auto &r = d->record(w);
+	r.hasSize = true;
+	r.size = sz;
+	return *this;
+}
+
+XFramelessGeometryTransaction &XFramelessGeometryTransaction::setMinimumSize(XFramelessWidget *w,
+	const QSize &sz)
+{
+	Q_D(XFramelessGeometryTransaction);
+	auto &r = d->record(w);
+	r.hasMinimumSize = true;
+	r.minimumSize = sz;
+	return *this;
+}
+
+XFramelessGeometryTransaction &XFramelessGeometryTransaction::setMaximumSize(XFramelessWidget *w,
+	const QSize &sz)
+{
+	Q_D(XFramelessGeometryTransaction);
+	auto &r = d->record(w);
+	r.hasMaximumSize = true;
+	r.maximumSize = sz;
+	return *this;
+}
+
+XFramelessGeometryTransaction &XFramelessGeometryTransaction::setWindowState(XFramelessWidget *w,
+	Qt::WindowStates state)
+{
+	Q_D(XFramelessGeometryTransaction);
+	auto &r = d->record(w);
+	r.hasState = true;
+	r.state = state;
+	return *this;
+}
+
+bool XFramelessGeometryTransaction::isEmpty() const
+{
+	Q_D(const XFramelessGeometryTransaction);
+	return d->_records.isEmpty();
+}
+
+void XFramelessGeometryTransaction::commit()
+{
+	Q_D(XFramelessGeometryTransaction);
+	d->doCommit();
+}
+
+void XFramelessGeometryTransaction::discard()
+{
+	Q_D(XFramelessGeometryTransaction);
+	d->_records.clear();
+}
@@ -0,0 +1,36 @@
+#ifndef XFRAMELESSGEOMETRYTRANSACTION_H
+#define XFRAMELESSGEOMETRYTRANSACTION_H
+
+#include "xframelesswidget.h"
+
+#include "QtCore/QPoint"
+#include "QtCore/QRect"
+#include "QtCore/QScopedPointer"
+#include "QtCore/QSize"
+
+class XFramelessGeometryTransactionPrivate;
+
+class X_FRAMELESS_WIDGET_EXPORT XFramelessGeometryTransaction
+{
+public:
+	XFramelessGeometryTransaction();
+	~XFramelessGeometryTransaction();
+
+	XFramelessGeometryTransaction &setGeometry(XFramelessWidget *w, const QRect &rect);
+	XFramelessGeometryTransaction &move(XFramelessWidget *w, const QPoint &pos);
+	XFramelessGeometryTransaction &resize(XFramelessWidget *w, const QSize &sz);
+	XFramelessGeometryTransaction &setMinimumSize(XFramelessWidget *w, const QSize &sz);
+	XFramelessGeometryTransaction &setMaximumSize(XFramelessWidget *w, const QSize &sz);
+	XFramelessGeometryTransaction &setWindowState(XFramelessWidget *w, Qt::WindowStates state);
+
+	bool isEmpty() const;
+	void commit();
+	void discard();
+
+private:
+	Q_DISABLE_COPY(XFramelessGeometryTransaction)
+	Q_DECLARE_PRIVATE(XFramelessGeometryTransaction);
+	QScopedPointer<XFramelessGeometryTransactionPrivate> d_ptr;
+};
+
+#endif // XFRAMELESSGEOMETRYTRANSACTION_H
@@ -0,0 +1,407 @@
+#include "xframelesslayoutstore.h"
+
+#include "QtCore/QDebug"
+#include "QtCore/QFile"
+#include "QtCore/QHash"
+#include "QtCore/QSaveFile"
+#include "QtCore/QVector"
+#include "QtCore/QtEndian"
+#include "QtGui/QGuiApplication"
+#include "QtGui/QScreen"
+#include "QtGui/QWindow"
+
+#if defined(Q_OS_WIN)
+#include <windows.h>
+#endif
+
+#include <algorithm>
+
+namespace
+{
+	constexpr quint32 kLayoutMagic = 0x534c4658; // "XFLS"
+	constexpr quint32 kLayoutVersion = 1;
+
+	struct LayoutHeader
+	{
+		quint32 magic;
+		quint32 version;
+		quint32 recordSize;
+		quint32 count;
+	};
+
+	/*!
+	 * One window. Records are sorted by key so a lookup is a binary search 
+	 * over the mapped file.
+	 */
+	struct LayoutRecord
+	{
+		quint64 key;
+		qint32 x;
+		qint32 y;
+		qint32 width;
+		qint32 height;
+		quint32 screen;
+		quint32 states;
+		quint32 captionParts;
+		quint32 flags;
+	};
+
+	// LayoutRecord::flags, zero in records written before there were any;
+	enum LayoutRecordFlag
+	{
+		// captionParts is valid, even if no part was visible;
+		kRecordCaptionParts = 0x01,
+	};
+
+	static_assert(sizeof(LayoutHeader) == 16, "unexpected layout header size");
+	static_assert(sizeof(LayoutRecord) == 40, "unexpected layout record size");
+
+	// FNV-1a; qHash is seeded per process, so it cannt be persisted;
+	quint64 stableHash(const QString &s)
+	{
+		quint64 h = 14695981039346656037ULL;
+		for (const char c : s.toUtf8())
+		{
+			h ^= static_cast<quint8>(c);
+			h *= 1099511628211ULL;
+		}
+		return h;
+	}
+
+	quint32 screenHash(const QString &name)
+	{
+		const quint64 h = stableHash(name);
+		return static_cast<quint32>(h ^ (h >> 32));
+	}
+
+	/*!
+	 * The geometry to restore later, the normal one for a window that is
+	 * maximized, fullscreen or minimized. On Windows the widget is a child
+	 * of its WinNativeWindow and that native window is the top-level, so
+	 * its rect is read back in device pixels and scaled like
+	 * XFramelessWidget::setGeometry() scales it.
+	 */
+	QRect captureGeometry(const XFramelessWidget *w)
+	{
+		const bool special = w->isMaximized() || w->isFullScreen() || w->isMinimized();
+#if defined(Q_OS_WIN)
+		const HWND hwnd = reinterpret_cast<HWND>(
+			w->property("_q_embedded_native_parent_handle").value<WId>());
+		RECT r;
+		WINDOWPLACEMENT placement;
+		placement.length = sizeof(placement);
+		if (special && hwnd && ::GetWindowPlacement(hwnd, &placement))
+		{
+			r = placement.rcNormalPosition;
+		}
+		else if (!hwnd || !::GetWindowRect(hwnd, &r))
+		{
+			return w->geometry();
+		}
+		const qreal dpr = w->window()->devicePixelRatio();
+		return QRect(qRound(r.left / dpr), qRound(r.top / dpr),
+			qRound((r.right - r.left) / dpr), qRound((r.bottom - r.top) / dpr));
+#else
+		return special ? w->normalGeometry() : w->geometry();
+#endif
+	}
+
+	QScreen *windowScreen(const QWidget *w)
+	{
+		if (w->windowHandle() && w->windowHandle()->screen())
+		{
+			return w->windowHandle()->screen();
+		}
+		QScreen *screen = QGuiApplication::screenAt(w->geometry().center());
+		return screen ? screen : QGuiApplication::primaryScreen();
+	}
+}
+
+class XFramelessLayoutStorePrivate final
+{
+public:
+	explicit XFramelessLayoutStorePrivate(const QString &fileName)
+		: _file(fileName)
+		, _records(Q_NULLPTR)
+		, _count(0)
+	{
+	}
+
+	~XFramelessLayoutStorePrivate()
+	{
+		unmap();
+	}
+
+	bool doLoad()
+	{
+		unmap();
+		if (!_file.open(QIODevice::ReadOnly))
+		{
+			return false;
+		}
+		if (_file.size() < static_cast<qint64>(sizeof(LayoutHeader)))
+		{
+			_file.close();
+			return false;
+		}
+
+		uchar *data = _file.map(0, _file.size());
+		if (!data)
+		{
+			qWarning() << "XFramelessLayoutStore: cannt map" << _file.fileName();
+			_file.close();
+			return false;
+		}
+
+		// the records are used in place, so everything the mapping is read
+		// through is checked first: the magic also rejects a file written
+		// with the other byte order, and the count has to match the size;
+		const LayoutHeader *header = reinterpret_cast<const LayoutHeader *>(data);
+		const qint64 expected = sizeof(LayoutHeader) 
+			+ static_cast<qint64>(header->count) * sizeof(LayoutRecord);
+		if (header->magic != kLayoutMagic || header->version != kLayoutVersion
+			|| header->recordSize != sizeof(LayoutRecord) || _file.size() != expected)
+		{
+			qWarning() << "XFramelessLayoutStore: ignoring incompatible" << _file.fileName()
+				<< (header->magic == qbswap(kLayoutMagic) ? "(other byte order)" : "");
+			_file.unmap(data);
+			_file.close();
+			return false;
+		}
+
+		_map = data;
+		_records = reinterpret_cast<const LayoutRecord *>(data + sizeof(LayoutHeader));
+		_count = header->count;
+		return true;
+	}
+
+	bool doSave()
+	{
+		// merge the mapped records with what was captured since;
+		QHash<quint64, LayoutRecord> all = _captured;
+		for (quint32 i = 0; i < _count; ++i)
+		{
+			if (!all.contains(_records[i].key))
+			{
+				all.insert(_records[i].key, _records[i]);
+			}
+		}
+		QVector<LayoutRecord> sorted;
+		sorted.reserve(all.size());
+		for (const LayoutRecord &r : qAsConst(all))
+		{
+			sorted.append(r);
+		}
+		std::sort(sorted.begin(), sorted.end(), [](const LayoutRecord &a, const LayoutRecord &b) {
+			return a.key < b.key;
+		});
+
+		LayoutHeader header;
+		header.magic = kLayoutMagic;
+		header.version = kLayoutVersion;
+		header.recordSize = sizeof(LayoutRecord);
+		header.count = static_cast<quint32>(sorted.size());
+
+		// everything is copied: release the mapping, Windows cannt replace
+		// a file that is still open or mapped;
+		unmap();
+		QSaveFile out(_file.fileName());
+		if (!out.open(QIODevice::WriteOnly))
+		{
+			doLoad();
+			return false;
+		}
+		out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+		if (!sorted.isEmpty())
+		{
+			out.write(reinterpret_cast<const char *>(sorted.constData()), 
+				sorted.size() * sizeof(LayoutRecord));
+		}
+		if (!out.commit())
+		{
+			// the captured layouts are kept for the next attempt;
+			doLoad();
+			return false;
+		}
+
+		_captured.clear();
+		return doLoad();
+	}
+
+	const LayoutRecord *find(const QString &key) const
+	{
+		const quint64 h = stableHash(key);
+		auto it = _captured.constFind(h);
+		if (it != _captured.constEnd())
+		{
+			return &it.value();
+		}
+
+		const LayoutRecord *end = _records + _count;
+		const LayoutRecord *r = std::lower_bound(_records, end, h, 
+			[](const LayoutRecord &a, quint64 k) { return a.key < k; });
+		return (r != end && r->key == h) ? r : Q_NULLPTR;
+	}
+
+	void doCapture(const XFramelessWidget *w, const QString &key)
+	{
+		Q_ASSERT_X(w != Q_NULLPTR, __FUNCTION__, "widget cannt be empty");
+		const QRect g = captureGeometry(w);
+
+		LayoutRecord r;
+		r.key = stableHash(key);
+		r.x = g.x();
+		r.y = g.y();
+		r.width = g.width();
+		r.height = g.height();
+		r.screen = screenHash(windowScreen(w)->name());
+		r.states = static_cast<quint32>(w->windowStates());
+		r.states |= (w->windowFlags() & Qt::WindowStaysOnTopHint) 
+			? XFramelessLayoutStore::kStateStaysOnTop : 0;
+		r.captionParts = 0;
+		r.flags = 0;
+#if defined(Q_OS_WIN) || defined(Q_OS_LINUX)
+		const auto capWgt = qobject_cast<const XFramelessWidgetWithCaption *>(w);
+		if (capWgt && capWgt->layout())
+		{
+			r.captionParts = static_cast<quint32>(
+				const_cast<XFramelessWidgetWithCaption *>(capWgt)->captionItf()->visibleParts());
+			r.flags |= kRecordCaptionParts;
+		}
+#endif
+		_captured.insert(r.key, r);
+	}
+
+	bool doRestore(XFramelessWidget *w, const QString &key) const
+	{
+		Q_ASSERT_X(w != Q_NULLPTR, __FUNCTION__, "widget cannt be empty");
+		if (w->isVisible())
+		{
+			qWarning() << "XFramelessLayoutStore: restore before the window is shown";
+			return false;
+		}
+		const LayoutRecord *r = find(key);
+		if (!r)
+		{
+			return false;
+		}
+
+		QRect g(r->x, r->y, r->width, r->height);
+		QScreen *screen = Q_NULLPTR;
+		for (QScreen *s : QGuiApplication::screens())
+		{
+			if (screenHash(s->name()) == r->screen)
+			{
+				screen = s;
+				break;
+			}
+		}
+		if (!screen)
+		{
+			// the screen is gone, keep the window reachable;
+			screen = QGuiApplication::primaryScreen();
+			const QRect avail = screen->availableGeometry();
+			g.setSize(g.size().boundedTo(avail.size()));
+			g.moveCenter(avail.center());
+		}
+		w->setGeometry(g.x(), g.y(), g.width(), g.height());
+
+		if (r->states)
+		{
+			// not shown yet, so the window is mapped in these states directly;
+			w->setWindowStates(static_cast<int>(r->states));
+		}
+
+#if defined(Q_OS_WIN) || defined(Q_OS_LINUX)
+		auto capWgt = qobject_cast<XFramelessWidgetWithCaption *>(w);
+		if (capWgt && capWgt->layout() && ((r->flags & kRecordCaptionParts) || r->captionParts))
+		{
+			capWgt->captionItf()->setVisibleParts(static_cast<int>(r->captionParts));
+		}
+#endif
+		return true;
+	}
+
+	QFile _file;
+
+private:
+	void unmap()
+	{
+		if (_map)
+		{
+			_file.unmap(_map);
+			_map = Q_NULLPTR;
+		}
+		if (_file.isOpen())
+		{
+			_file.close();
+		}
+		_records = Q_NULLPTR;
+		_count = 0;
+	}
+
+	uchar *_map = Q_NULLPTR;
+	const LayoutRecord *_records;
+	quint32 _count;
+	QHash<quint64, LayoutRecord> _captured;
+};
+
+/*!
+	\class XFramelessLayoutStore
+	\brief Binary store of window layouts for fast session restore.
+
+	Every window is identified by a key chosen by the application. The store 
+	keeps its geometry, screen, window state and the visible caption parts
+	in a small versioned file that is memory-mapped on load(), so restoring
+	a window is a binary search in the mapping and no per-window parsing.
+
+	Call restore() before the window is shown for the first time: the window
+	is then mapped with its final geometry and state instead of being 
+	reconfigured after it appears. capture() records the current layout of
+	a window and save() writes everything back to disk.
+*/
+XFramelessLayoutStore::XFramelessLayoutStore(const QString &fileName)
+	: d_ptr(new XFramelessLayoutStorePrivate(fileName))
+{
+}
+
+XFramelessLayoutStore::~XFramelessLayoutStore()
+{
+}
+
+bool XFramelessLayoutStore::load()
+{
+	Q_D(XFramelessLayoutStore);
+	return d->doLoad();
+}
+
+bool XFramelessLayoutStore::save()
+{
+	Q_D(XFramelessLayoutStore);
+	return d->doSave();
+}
+
+void XFramelessLayoutStore::capture(const XFramelessWidget *w, const QString &key)
+{
+	Q_D(XFramelessLayoutStore);
+	d->doCapture(w, key);
+}
+
+bool XFramelessLayoutStore::restore(XFramelessWidget *w, const QString &key) const
+{
+	Q_D(const XFramelessLayoutStore);
+	return d->doRestore(w, key);
+}
+
+bool XFramelessLayoutStore::contains(const QString &key) const
+{
+	Q_D(const XFramelessLayoutStore);
+	return d->find(key) != Q_NULLPTR;
+}
+
+int XFramelessLayoutStore::stateFlags(const QString &key) const
+{
+	Q_D(const XFramelessLayoutStore);
+	const LayoutRecord *r = d->find(key);
+	return r ? static_cast<int>(r->states) : 0;
+}
@@ -0,0 +1,43 @@
+#ifndef XFRAMELESSLAYOUTSTORE_H
+#define XFRAMELESSLAYOUTSTORE_H
+
+#include "xframelesswidget.h"
+
+#include "QtCore/QScopedPointer"
+#include "QtCore/QString"
+
+class XFramelessLayoutStorePrivate;
+
+class X_FRAMELESS_WIDGET_EXPORT XFramelessLayoutStore
+{
+public:
+	// same bits as XFramelessWidget::WindowStateFlag;
+	enum StateFlag
+	{
+		kStateMaximized = 0x01,
+		kStateFullScreen = 0x02,
+		kStateMinimized = 0x04,
+		kStateStaysOnTop = 0x08,
+		kStateSkipTaskbar = 0x10,
+		kStateSkipPager = 0x20,
+	};
+
+	explicit XFramelessLayoutStore(const QString &fileName);
+	~XFramelessLayoutStore();
+
+	bool load();
+	bool save();
+
+	void capture(const XFramelessWidget *w, const QString &key);
+	bool restore(XFramelessWidget *w, const QString &key) const;
+
+	bool contains(const QString &key) const;
+	int stateFlags(const QString &key) const;
+
+private:
+	Q_DISABLE_COPY(XFramelessLayoutStore)
+	Q_DECLARE_PRIVATE(XFramelessLayoutStore);
+	QScopedPointer<XFramelessLayoutStorePrivate> d_ptr;
+};
+
+#endif // XFRAMELESSLAYOUTSTORE_H
@@ -0,0 +1,306 @@
+#include "xframelessquickwindow.h"
+
+#include "QtCore/QPointer"
+#include "QtGui/QMouseEvent"
+#include "QtGui/QScreen"
+
+#include "xframelesscontext.h"
+#include "xutil_linux.h"
+
+namespace
+{
+	constexpr int ResizeHandleWidth = 10;
+}
+
+class XFramelessQuickWindowPrivate final
+{
+public:
+	explicit XFramelessQuickWindowPrivate(XFramelessQuickWindow *q)
+		: q_ptr(q)
+	{
+	}
+
+	~XFramelessQuickWindowPrivate()
+	{
+		_context->removeNetSupportedHandler(this);
+	}
+
+	void init()
+	{
+		Q_Q(XFramelessQuickWindow);
+		q->setFlags(q->flags() | Qt::FramelessWindowHint);
+		_isX11 = xutils_linux::IsPlatformX11();
+		// another WM may lack _NET_WM_MOVERESIZE, ask again on the next press;
+		_context->setNetSupportedHandler(this, [this]() { _wmMoveResize = -1; });
+		// no resize bands while fullscreen;
+		QObject::connect(q, &QWindow::visibilityChanged, q, [this]() { updateNativeFrame(); });
+	}
+
+	/*!
+	 * Same extents and input shape as XFramelessWidget writes: the margins
+	 * are _GTK_FRAME_EXTENTS, input is taken by the content and the resize
+	 * bands around it only. A fullscreen window has neither, the WM would
+	 * otherwise keep the shadow margins off the screen edges.
+	 */
+	void updateNativeFrame()
+	{
+		Q_Q(XFramelessQuickWindow);
+		if (!_isX11 || !q->handle())
+		{
+			return;
+		}
+		const QMargins margins = q->visibility() == QWindow::FullScreen
+			? QMargins() : _shadowMargins;
+		xutils_linux::BeginBatch();
+		xutils_linux::SetWindowExtents(q->winId(), QRect(QPoint(), q->size()), margins,
+			resizeHandleWidth());
+		xutils_linux::EndBatch();
+	}
+
+	bool doMousePressWork(QMouseEvent *event)
+	{
+		Q_Q(XFramelessQuickWindow);
+		if (event->button() != Qt::LeftButton)
+		{
+			return false;
+		}
+		const xutils_linux::CornerEdge ce = cornerEdge(event->pos());
+		if (ce == xutils_linux::CornerEdge::kInvalid)
+		{
+			return false;
+		}
+
+		if (useWmMoveResize())
+		{
+			// the WM grabs the pointer, the scene never sees the release;
+			const QPoint rootPos = xutils_linux::ToNativePixels(q, event->globalPos());
+			xutils_linux::SendButtonRelease(q->winId(), event->pos() * q->devicePixelRatio(), rootPos);
+			xutils_linux::StartResizing(q->winId(), rootPos, ce, event->timestamp());
+			return true;
+		}
+#if QT_VERSION >= QT_VERSION_CHECK(5, 15, 0)
+		return q->startSystemResize(xutils_linux::CornerEdge2QtEdges(ce));
+#else
+		// nothing can resize the window, the scene gets the press;
+		return false;
+#endif
+	}
+
+	// after the scene had the press: a press on the caption no item took;
+	void doCaptionPressWork(QMouseEvent *event)
+	{
+		Q_Q(XFramelessQuickWindow);
+		if (event->button() != Qt::LeftButton || q->mouseGrabberItem() || !_captionItem
+			|| !_captionItem->isVisible()
+			|| !_captionItem->contains(_captionItem->mapFromScene(event->windowPos())))
+		{
+			return;
+		}
+
+		if (useWmMoveResize())
+		{
+			const QPoint rootPos = xutils_linux::ToNativePixels(q, event->globalPos());
+			xutils_linux::SendButtonRelease(q->winId(), event->pos() * q->devicePixelRatio(), rootPos);
+			xutils_linux::MoveWindow(q->winId(), event->button(), rootPos, event->timestamp());
+		}
+#if QT_VERSION >= QT_VERSION_CHECK(5, 15, 0)
+		else
+		{
+			q->startSystemMove();
+		}
+#endif
+	}
+
+	void updateCursorShape(const QPoint &pos)
+	{
+		Q_Q(XFramelessQuickWindow);
+		const xutils_linux::CornerEdge ce = cornerEdge(pos);
+		if (ce == _cursorEdge)
+		{
+			return;
+		}
+		_cursorEdge = ce;
+		if (ce != xutils_linux::CornerEdge::kInvalid)
+		{
+			q->setCursor(xutils_linux::CornerEdge2QtCursor(ce));
+		}
+		else
+		{
+			q->unsetCursor();
+		}
+	}
+
+	xutils_linux::CornerEdge cornerEdge(const QPoint &pos) const
+	{
+		Q_Q(const XFramelessQuickWindow);
+		return xutils_linux::GetCornerEdge(QRect(QPoint(), q->size()), pos.x(), pos.y(),
+			hitMargins(), resizeHandleWidth());
+	}
+
+	// the resize bands lie outside these margins: in the shadow margins, or
+	// along the inside of the window edge when there are none;
+	QMargins hitMargins() const
+	{
+		if (_shadowMargins.isNull())
+		{
+			const int w = resizeHandleWidth();
+			return QMargins(w, w, w, w);
+		}
+		return _shadowMargins;
+	}
+
+	int resizeHandleWidth() const
+	{
+		Q_Q(const XFramelessQuickWindow);
+		return q->visibility() == QWindow::FullScreen ? 0 : ResizeHandleWidth;
+	}
+
+	bool useWmMoveResize()
+	{
+		if (_wmMoveResize < 0)
+		{
+			_wmMoveResize = _isX11 && xutils_linux::IsMoveResizeSupported() ? 1 : 0;
+		}
+		return _wmMoveResize > 0;
+	}
+
+private:
+	Q_DECLARE_PUBLIC(XFramelessQuickWindow);
+	XFramelessQuickWindow *q_ptr;
+	// the atom and _NET_SUPPORTED caches are shared with the widgets;
+	XFramelessContext::Ref _context;
+
+	bool _isX11 = false;
+	// -1 until the first press, then whether _NET_WM_MOVERESIZE is used;
+	int _wmMoveResize = -1;
+	QMargins _shadowMargins;
+	QPointer<QQuickItem> _captionItem;
+	xutils_linux::CornerEdge _cursorEdge = xutils_linux::CornerEdge::kInvalid;
+};
+
+/*!
+	\class XFramelessQuickWindow
+	\brief The XFramelessQuickWindow class is a frameless QQuickWindow.
+
+	It shares XFramelessWidget's Linux code for hit testing, the frame
+	extents and input shape, and the _NET_WM_MOVERESIZE hand-off, while the
+	content renders through Qt Quick's render loop, threaded where the scene
+	graph backend supports it, instead of the raster backing store on the
+	GUI thread. Animations keep running while the window manager moves or
+	resizes the window.
+
+	To draw the shadow, give the window an alpha channel
+	(QSurfaceFormat::setAlphaBufferSize(8)) and a transparent color, and
+	draw the shadow in the scene. Without an X server, e.g. on Wayland,
+	moving and resizing use QWindow::startSystemMove() and
+	QWindow::startSystemResize() (Qt 5.15).
+*/
+XFramelessQuickWindow::XFramelessQuickWindow(QWindow *parent /*= Q_NULLPTR*/)
+	: QQuickWindow(parent),
+	d_ptr(new XFramelessQuickWindowPrivate(this))
+{
+	Q_D(XFramelessQuickWindow);
+	d->init();
+}
+
+/*!
+    Destroys this object, freeing all allocated resources.
+*/
+XFramelessQuickWindow::~XFramelessQuickWindow()
+{
+}
+
+/*!
+	Sets the transparent area around the content, which holds the resize
+	bands. Without margins the bands lie along the inside of the window
+	edge.
+*/
+void XFramelessQuickWindow::setShadowMargins(const QMargins &margins)
+{
+	Q_D(XFramelessQuickWindow);
+	if (margins == d->_shadowMargins)
+	{
+		return;
+	}
+	d->_shadowMargins = margins;
+	d->updateNativeFrame();
+}
+
+QMargins XFramelessQuickWindow::shadowMargins() const
+{
+	Q_D(const XFramelessQuickWindow);
+	return d->_shadowMargins;
+}
+
+/*!
+	Sets the item that moves the window: a press on it that no item inside
+	the scene accepts starts a window move.
+*/
+void XFramelessQuickWindow::setCaptionItem(QQuickItem *item)
+{
+	Q_D(XFramelessQuickWindow);
+	if (item == d->_captionItem)
+	{
+		return;
+	}
+	d->_captionItem = item;
+	emit captionItemChanged();
+}
+
+QQuickItem *XFramelessQuickWindow::captionItem() const
+{
+	Q_D(const XFramelessQuickWindow);
+	return d->_captionItem;
+}
+
+void XFramelessQuickWindow::showCenter()
+{
+	const QScreen *s = screen();
+	if (s)
+	{
+		setPosition(s->availableGeometry().center() - QPoint(width() / 2, height() / 2));
+	}
+	show();
+}
+
+void XFramelessQuickWindow::mouseMoveEvent(QMouseEvent *e)
+{
+	Q_D(XFramelessQuickWindow);
+	QQuickWindow::mouseMoveEvent(e);
+	// after the scene, which sets the cursor of the item below;
+	if (e->buttons() == Qt::NoButton)
+	{
+		d->updateCursorShape(e->pos());
+	}
+}
+
+void XFramelessQuickWindow::mousePressEvent(QMouseEvent *e)
+{
+	Q_D(XFramelessQuickWindow);
+	// presses on the resize bands that start a resize never reach the scene;
+	if (d->doMousePressWork(e))
+	{
+		e->accept();
+		return;
+	}
+	QQuickWindow::mousePressEvent(e);
+	d->doCaptionPressWork(e);
+}
+
+void XFramelessQuickWindow::resizeEvent(QResizeEvent *e)
+{
+	Q_D(XFramelessQuickWindow);
+	QQuickWindow::resizeEvent(e);
+	d->updateNativeFrame();
+}
+
+/*!
+	The native window exists but is not mapped yet, so the window manager
+	finds the extents and input shape in place.
+*/
+void XFramelessQuickWindow::showEvent(QShowEvent *e)
+{
+	Q_D(XFramelessQuickWindow);
+	d->updateNativeFrame();
+	QQuickWindow::showEvent(e);
+}
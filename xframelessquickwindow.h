@@ -0,0 +1,46 @@
+#ifndef XFRAMELESSQUICKWINDOW_H
+#define XFRAMELESSQUICKWINDOW_H
+
+#ifdef X_FRAMELESS_WIDGET_SHARED
+#define X_FRAMELESS_WIDGET_EXPORT Q_DECL_EXPORT
+#else
+#define X_FRAMELESS_WIDGET_EXPORT Q_DECL_IMPORT
+#endif
+
+#include "QtCore/QMargins"
+#include "QtCore/QScopedPointer"
+#include "QtQuick/QQuickItem"
+#include "QtQuick/QQuickWindow"
+
+class XFramelessQuickWindowPrivate;
+
+class X_FRAMELESS_WIDGET_EXPORT XFramelessQuickWindow : public QQuickWindow
+{
+	Q_OBJECT
+	Q_PROPERTY(QQuickItem *captionItem READ captionItem WRITE setCaptionItem NOTIFY captionItemChanged)
+
+public:
+	explicit XFramelessQuickWindow(QWindow *parent = Q_NULLPTR);
+	virtual ~XFramelessQuickWindow();
+
+	void setShadowMargins(const QMargins &margins);
+	QMargins shadowMargins() const;
+	void setCaptionItem(QQuickItem *item);
+	QQuickItem *captionItem() const;
+
+	void showCenter();
+
+	Q_SIGNAL void captionItemChanged();
+
+protected:
+	void mouseMoveEvent(QMouseEvent *) Q_DECL_OVERRIDE;
+	void mousePressEvent(QMouseEvent *) Q_DECL_OVERRIDE;
+	void resizeEvent(QResizeEvent *) Q_DECL_OVERRIDE;
+	void showEvent(QShowEvent *) Q_DECL_OVERRIDE;
+
+private:
+	Q_DECLARE_PRIVATE(XFramelessQuickWindow);
+	QScopedPointer<XFramelessQuickWindowPrivate> d_ptr;
+};
+
+#endif // XFRAMELESSQUICKWINDOW_H
@@ -0,0 +1,149 @@
+#include "xframelessscreenmodel.h"
+
+#include "QtGui/QCursor"
+#include "QtGui/QGuiApplication"
+#include "QtGui/QWindow"
+#include "QtWidgets/QWidget"
+
+XFramelessScreenModel::XFramelessScreenModel()
+	: _valid(false)
+{
+	if (qApp)
+	{
+		auto invalidator = [this]() { invalidate(); };
+		_appConnections.append(QObject::connect(qApp, &QGuiApplication::screenAdded, invalidator));
+		_appConnections.append(QObject::connect(qApp, &QGuiApplication::screenRemoved, invalidator));
+		_appConnections.append(QObject::connect(qApp, &QGuiApplication::primaryScreenChanged, 
+			invalidator));
+	}
+}
+
+XFramelessScreenModel::~XFramelessScreenModel()
+{
+	for (const auto &c : qAsConst(_appConnections))
+	{
+		QObject::disconnect(c);
+	}
+	disconnectScreens();
+}
+
+void XFramelessScreenModel::invalidate()
+{
+	_valid = false;
+}
+
+void XFramelessScreenModel::ensureValid()
+{
+	if (!_valid)
+	{
+		rebuild();
+	}
+}
+
+void XFramelessScreenModel::disconnectScreens()
+{
+	for (const auto &c : qAsConst(_screenConnections))
+	{
+		QObject::disconnect(c);
+	}
+	_screenConnections.clear();
+}
+
+/*!
+ * On X11 QScreen::availableGeometry() is the screen clipped to _NET_WORKAREA, 
+ * and Qt already follows the root window property for it, so the cache 
+ * stores that rather than reading the property again.
+ */
+void XFramelessScreenModel::rebuild()
+{
+	disconnectScreens();
+	_screens.clear();
+
+	auto invalidator = [this]() { invalidate(); };
+	for (QScreen *s : QGuiApplication::screens())
+	{
+		Screen entry;
+		entry.screen = s;
+		entry.geometry = s->geometry();
+		entry.availableGeometry = s->availableGeometry();
+		entry.devicePixelRatio = s->devicePixelRatio();
+		_screens.append(entry);
+
+		_screenConnections.append(QObject::connect(s, &QScreen::geometryChanged, invalidator));
+		_screenConnections.append(QObject::connect(s, &QScreen::availableGeometryChanged, 
+			invalidator));
+		_screenConnections.append(QObject::connect(s, &QScreen::logicalDotsPerInchChanged, 
+			invalidator));
+	}
+	_valid = true;
+}
+
+const XFramelessScreenModel::Screen *XFramelessScreenModel::find(const QScreen *screen)
+{
+	ensureValid();
+	for (const Screen &s : qAsConst(_screens))
+	{
+		if (s.screen == screen)
+		{
+			return &s;
+		}
+	}
+	return Q_NULLPTR;
+}
+
+const XFramelessScreenModel::Screen *XFramelessScreenModel::primary()
+{
+	ensureValid();
+	const Screen *s = find(QGuiApplication::primaryScreen());
+	if (!s && !_screens.isEmpty())
+	{
+		s = &_screens.first();
+	}
+	return s;
+}
+
+const XFramelessScreenModel::Screen *XFramelessScreenModel::screenAt(const QPoint &globalPos)
+{
+	ensureValid();
+	for (const Screen &s : qAsConst(_screens))
+	{
+		if (s.geometry.contains(globalPos))
+		{
+			return &s;
+		}
+	}
+	return primary();
+}
+
+const XFramelessScreenModel::Screen *XFramelessScreenModel::screenOf(const QWidget *w)
+{
+	if (!w)
+	{
+		return primary();
+	}
+	const QWidget *window = w->window();
+	if (window->windowHandle() && window->windowHandle()->screen())
+	{
+		if (const Screen *s = find(window->windowHandle()->screen()))
+		{
+			return s;
+		}
+	}
+	return screenAt(window->geometry().center());
+}
+
+const XFramelessScreenModel::Screen *XFramelessScreenModel::screenForPlacing(const QWidget *w)
+{
+	if (w && w->parentWidget())
+	{
+		return screenOf(w->parentWidget());
+	}
+	if (w && w->windowHandle() && w->windowHandle()->transientParent())
+	{
+		if (const Screen *s = find(w->windowHandle()->transientParent()->screen()))
+		{
+			return s;
+		}
+	}
+	return screenAt(QCursor::pos());
+}
@@ -0,0 +1,55 @@
+#ifndef XFRAMELESSSCREENMODEL_H
+#define XFRAMELESSSCREENMODEL_H
+
+#include "QtCore/QMetaObject"
+#include "QtCore/QPointer"
+#include "QtCore/QRect"
+#include "QtCore/QVector"
+#include "QtGui/QScreen"
+
+class QWidget;
+
+/*!
+ * \internal
+ * Cached geometry, work area and device pixel ratio of every screen.
+ * The cache is rebuilt lazily after QScreen/QGuiApplication report a 
+ * change (RandR and _NET_WORKAREA changes on X11, WM_DISPLAYCHANGE and
+ * friends on Windows), so queries cost no window system round trips.
+ */
+class XFramelessScreenModel final
+{
+public:
+	struct Screen
+	{
+		QPointer<QScreen> screen;
+		QRect geometry;
+		QRect availableGeometry;
+		qreal devicePixelRatio;
+	};
+
+	XFramelessScreenModel();
+	~XFramelessScreenModel();
+
+	const Screen *primary();
+	const Screen *screenAt(const QPoint &globalPos);
+	const Screen *screenOf(const QWidget *w);
+	// screen of the parent window if any, otherwise the one under the cursor;
+	const Screen *screenForPlacing(const QWidget *w);
+
+	void invalidate();
+
+private:
+	Q_DISABLE_COPY(XFramelessScreenModel)
+
+	void ensureValid();
+	void rebuild();
+	void disconnectScreens();
+	const Screen *find(const QScreen *screen);
+
+	bool _valid;
+	QVector<Screen> _screens;
+	QVector<QMetaObject::Connection> _appConnections;
+	QVector<QMetaObject::Connection> _screenConnections;
+};
+
+#endif // XFRAMELESSSCREENMODEL_H
@@ -1,11 +1,16 @@
 #include "xframelesswidget.h"
 
 #include "QtCore/QDebug"
+#include "QtCore/QElapsedTimer"
+#include "QtCore/QTimer"
 #include "QtGui/QFocusEvent"
+#include "QtGui/QShowEvent"
+#include "QtGui/QWindow"
 #include "QtWidgets/QApplication"
-#include "QtWidgets/QDesktopWidget"
 
 #include "captionwidget.h"
+#include "lightcaptionwidget.h"
+#include "xframelesscontext.h"
 
 #if defined(Q_OS_WIN)
 #include <dwmapi.h>
@@ -14,7 +19,11 @@
 #elif defined(Q_OS_MACOS)
 #include "xutil_macos.h"
 #elif defined(Q_OS_LINUX)
+#include "xframelessbackend_linux.h"
+#include "xmoveresize_linux.h"
 #include "xutil_linux.h"
+
+#include <xcb/xcb.h>
 #endif
 
 namespace
@@ -23,6 +32,31 @@ namespace
 #elif defined(Q_OS_LINUX)
 	constexpr int ResizeHandleWidth = 10;
 #endif
+
+#if !defined(Q_OS_WIN)
+	constexpr int QtWindowStateFlags = XFramelessWidget::kWindowMaximized
+		| XFramelessWidget::kWindowFullScreen | XFramelessWidget::kWindowMinimized;
+
+	// the Qt::WindowStates of w with the bits of flags replacing its own;
+	Qt::WindowStates toQtWindowStates(const QWidget *w, const int flags)
+	{
+		Qt::WindowStates states = w->windowState()
+			& ~(Qt::WindowMaximized | Qt::WindowFullScreen | Qt::WindowMinimized);
+		states |= (flags & XFramelessWidget::kWindowMaximized) ? Qt::WindowMaximized : Qt::WindowNoState;
+		states |= (flags & XFramelessWidget::kWindowFullScreen) ? Qt::WindowFullScreen : Qt::WindowNoState;
+		states |= (flags & XFramelessWidget::kWindowMinimized) ? Qt::WindowMinimized : Qt::WindowNoState;
+		return states;
+	}
+
+	int fromQtWindowStates(const QWidget *w)
+	{
+		int flags = 0;
+		flags |= w->isMaximized() ? XFramelessWidget::kWindowMaximized : 0;
+		flags |= w->isFullScreen() ? XFramelessWidget::kWindowFullScreen : 0;
+		flags |= w->isMinimized() ? XFramelessWidget::kWindowMinimized : 0;
+		return flags;
+	}
+#endif
 }
 
 #if defined(Q_OS_WIN)
@@ -129,10 +163,57 @@ public:
 
 	void showParentWindow()
 	{
-		::ShowWindow(_nativeWindowHWnd, true);
+		::ShowWindow(_nativeWindowHWnd, _showCmd);
+		_showCmd = SW_SHOWNORMAL;
 		this->saveFocus();
 	}
 
+	/*!
+	 * Win32 has no pager, and dropping the taskbar button needs 
+	 * WS_EX_TOOLWINDOW, so the skip bits are only kept. A hidden window is
+	 * shown straight into the requested state by showParentWindow.
+	 */
+	void doSetWindowStates(const int flags)
+	{
+		_windowStates = flags;
+		const bool onTop = (flags & XFramelessWidget::kWindowStaysOnTop) != 0;
+		::SetWindowPos(_nativeWindowHWnd, onTop ? HWND_TOPMOST : HWND_NOTOPMOST, 0, 0, 0, 0,
+			SWP_NOMOVE | SWP_NOSIZE | SWP_NOACTIVATE);
+
+		if (!::IsWindowVisible(_nativeWindowHWnd))
+		{
+			_showCmd = (flags & XFramelessWidget::kWindowMinimized) ? SW_SHOWMINIMIZED
+				: (flags & XFramelessWidget::kWindowMaximized) ? SW_SHOWMAXIMIZED : SW_SHOWNORMAL;
+			return;
+		}
+
+		if (flags & XFramelessWidget::kWindowMinimized)
+		{
+			showMinimizedParentWindow();
+		}
+		else if (flags & XFramelessWidget::kWindowMaximized)
+		{
+			showMaximizedParentWindow();
+		}
+		else if (getIsMaximized() || ::IsIconic(_nativeWindowHWnd))
+		{
+			showNormalParentWindow();
+		}
+	}
+
+	int windowStateFlags() const
+	{
+		if (!::IsWindowVisible(_nativeWindowHWnd))
+		{
+			return _windowStates;
+		}
+		int flags = _windowStates & ~(XFramelessWidget::kWindowMaximized 
+			| XFramelessWidget::kWindowFullScreen | XFramelessWidget::kWindowMinimized);
+		flags |= getIsMaximized() ? XFramelessWidget::kWindowMaximized : 0;
+		flags |= ::IsIconic(_nativeWindowHWnd) ? XFramelessWidget::kWindowMinimized : 0;
+		return flags;
+	}
+
 	/*! 
 	 * to do:
 	 * https://stackoverflow.com/questions/2382464/win32-full-screen-and-hiding-taskbar
@@ -174,13 +255,19 @@ public:
 			qWarning("XFramelessWidget::center: Call this function only for "
 				"QWinWidgets with toplevel children");
 		}
+		const XFramelessScreenModel::Screen *screen = _context->screens().screenForPlacing(q);
+		if (!screen)
+		{
+			return;
+		}
 		RECT r;
 		::GetWindowRect(_nativeWindowHWnd, &r);
-		const auto widgetWidth = r.right - r.left;
-		const auto widgetHeight = r.bottom - r.top;
-		const auto desktopRect = QApplication::desktop()->screenGeometry();
-		const auto widgetX = (desktopRect.width() - widgetWidth) / 2;
-		const auto widgetY = (desktopRect.height() - widgetHeight) / 2;
+		const qreal dpr = q->window()->devicePixelRatio();
+		const auto widgetWidth = qRound((r.right - r.left) / dpr);
+		const auto widgetHeight = qRound((r.bottom - r.top) / dpr);
+		const auto desktopRect = screen->availableGeometry;
+		const auto widgetX = desktopRect.x() + (desktopRect.width() - widgetWidth) / 2;
+		const auto widgetY = desktopRect.y() + (desktopRect.height() - widgetHeight) / 2;
 		this->doSetGeometry(widgetX, widgetY, widgetWidth, widgetHeight);
 		q->show();
 	}
@@ -257,6 +344,13 @@ public:
 					return false;
 				}
 
+				// self-painted captions have their buttons inside the caption widget;
+				const CaptionIterface *capItf = dynamic_cast<const CaptionIterface *>(_capWgt);
+				if (capItf && !capItf->isDragArea(_capWgt->mapFromGlobal(QCursor::pos())))
+				{
+					return false;
+				}
+
 				/*!
 					The mouse is over the toolbar area & is NOT over a child of the toolbar, 
 					so pass this message through to the native window for HTCAPTION dragging
@@ -377,6 +471,7 @@ public:
 private:
 	Q_DECLARE_PUBLIC(XFramelessWidget);
 	XFramelessWidget *q_ptr;
+	XFramelessContext::Ref _context;
 	QWidget *_capWgt;
 
 	WinNativeWindow* _nativeWindow;
@@ -390,6 +485,9 @@ private:
 	// Adjust this as you wish for # of pixels from the top to allow dragging the window;
 	int _toolbarHeight = 40;
 
+	int _windowStates = 0;
+	int _showCmd = SW_SHOWNORMAL;
+
 	void saveFocus()
 	{
 		if (!_prevFocus)
@@ -415,133 +513,923 @@ private:
 		}
 		else
 		{
-			::SetFocus(_nativeWindowHWnd);
+			::SetFocus(_nativeWindowHWnd);
+		}
+	}
+};
+
+#elif defined(Q_OS_MACOS)
+
+class XFramelessWidgetPrivate final
+{
+public:
+	explicit XFramelessWidgetPrivate(XFramelessWidget* q)
+		:q_ptr(q)
+	{
+		qDebug() << "XFramelessWidgetPrivate()";
+	}
+
+	~XFramelessWidgetPrivate() {
+		qDebug() << "~XFramelessWidgetPrivate()";
+	}
+
+	void init()
+	{
+		Q_Q(XFramelessWidget);
+		xutils_macos::setupDialogTitleBar(q, true, true, true);
+	}
+
+	// there is nothing like a taskbar or pager hint, those bits are only kept;
+	void doSetWindowStates(const int flags)
+	{
+		Q_Q(XFramelessWidget);
+		_windowStates = flags;
+		const bool onTop = (flags & XFramelessWidget::kWindowStaysOnTop) != 0;
+		if (onTop != q->windowFlags().testFlag(Qt::WindowStaysOnTopHint))
+		{
+			const bool visible = q->isVisible();
+			q->setWindowFlags(onTop ? q->windowFlags() | Qt::WindowStaysOnTopHint
+				: q->windowFlags() & ~Qt::WindowStaysOnTopHint);
+			if (visible)
+			{
+				q->show();
+			}
+		}
+		q->setWindowState(toQtWindowStates(q, flags));
+	}
+
+	int windowStateFlags() const
+	{
+		Q_Q(const XFramelessWidget);
+		return (_windowStates & ~QtWindowStateFlags) | fromQtWindowStates(q);
+	}
+
+	void doShowCenter()
+	{
+		Q_Q(XFramelessWidget);
+		const XFramelessScreenModel::Screen *screen = _context->screens().screenForPlacing(q);
+		if (!screen)
+		{
+			return;
+		}
+		q->move(screen->availableGeometry.center() - q->rect().center());
+		q->show();
+	}
+
+private:
+	Q_DECLARE_PUBLIC(XFramelessWidget);
+	XFramelessWidget *q_ptr;
+	XFramelessContext::Ref _context;
+	int _windowStates = 0;
+};
+
+#elif defined(Q_OS_LINUX)
+
+class XFramelessWidgetPrivate final
+{
+public:
+	explicit XFramelessWidgetPrivate(XFramelessWidget* q)
+		:q_ptr(q)
+	{
+		qDebug() << "XFramelessWidgetPrivate()";
+	}
+
+	~XFramelessWidgetPrivate() {
+		qDebug() << "~XFramelessWidgetPrivate()";
+		_context->removeCompositingHandler(this);
+		_context->removeNetSupportedHandler(this);
+		// a pending callback is dropped with the widget;
+		if (_transition.window)
+		{
+			_context->removeNativeEventHandler(_transition.window);
+		}
+		destroyEdgeWindows();
+	}
+
+	void init()
+	{
+		Q_Q(XFramelessWidget);
+		q->setWindowFlags(Qt::FramelessWindowHint);
+		resizingCornerEdge = xutils_linux::CornerEdge::kInvalid;
+		_backend.reset(xutils_linux::Backend::create(q));
+		// only called once the state has been read, by isCompositing() or
+		// setAutoVisual();
+		_context->setCompositingHandler(this, [this](bool compositing) {
+			onCompositingChanged(compositing);
+		});
+		// only called once _NET_SUPPORTED has been read;
+		_context->setNetSupportedHandler(this, [this]() { onNetSupportedChanged(); });
+		_transitionTimer.setSingleShot(true);
+		QObject::connect(&_transitionTimer, &QTimer::timeout, q, [this]() {
+			finishTransition(false, _transition.serial);
+		});
+		// with a backend the edge windows own the border cursors, so plain
+		// hovering costs no motion events at all;
+		q->setMouseTracking(!_backend);
+	}
+
+	/*!
+	 * showEvent comes after the native window is created but before it is
+	 * mapped, which is the one point where all native setup can be written
+	 * in a single batch: nothing is read back from the server and the WM
+	 * finds the final hints, extents and input shape when it manages the
+	 * window, rather than having to reshape it after the first resize.
+	 */
+	void doShowWork(QShowEvent *e)
+	{
+		Q_Q(XFramelessWidget);
+		if (!_backend || e->spontaneous())
+		{
+			return;
+		}
+
+		_backend->beginBatch();
+		if (_configuredWindow != q->winId())
+		{
+			_configuredWindow = q->winId();
+			updateNativeFrame();
+		}
+		if (_netWmStatePending)
+		{
+			writeNetWmState();
+		}
+		_backend->endBatch();
+	}
+
+	void doShowCenter()
+	{
+		Q_Q(XFramelessWidget);
+		const XFramelessScreenModel::Screen *screen = _context->screens().screenForPlacing(q);
+		if (!screen)
+		{
+			return;
+		}
+		q->move(screen->availableGeometry.center() - q->rect().center());
+		q->show();
+	}
+
+	/*!
+	 * Qt takes a requested state as applied right away, so the transition
+	 * waits for the WM to write the new _NET_WM_STATE, or for the map of a
+	 * window shown in that state, then for the notify of a sync marker
+	 * written after it. The server sends events in order, so the geometry
+	 * the WM set for the new state is in by then, and done runs once Qt
+	 * delivered it to the widget.
+	 */
+	void doShowStateAsync(const int state, const XFramelessWidget::StateCallback &done,
+		const int timeoutMs)
+	{
+		Q_Q(XFramelessWidget);
+		const XFramelessWidget::StateCallback previous = takeTransition(_transition.serial);
+		if (previous)
+		{
+			// replaced; from the event loop, so it cannot start another
+			// transition in the middle of this one;
+			QTimer::singleShot(0, q, [previous]() { previous(false); });
+		}
+
+		_transition.pending = true;
+		_transition.done = done;
+		_transition.state = state;
+		_transition.confirmed = false;
+		const int serial = ++_transition.serial;
+
+		const bool tracked = _backend && _backend->confirmsWindowStates();
+		const bool reached = q->isVisible() && (windowStateFlags() & QtWindowStateFlags) == state;
+		if (tracked && !reached)
+		{
+			_transition.mapped = q->isVisible();
+			_transition.window = q->winId();
+			_context->setNativeEventHandler(_transition.window, [this](void *event) {
+				return handleTransitionEvent(event);
+			});
+			_transitionTimer.start(timeoutMs);
+		}
+
+		switch (state)
+		{
+		case XFramelessWidget::kWindowFullScreen:
+			q->showFullScreen();
+			break;
+		case XFramelessWidget::kWindowMaximized:
+			q->showMaximized();
+			break;
+		case XFramelessWidget::kWindowMinimized:
+			q->showMinimized();
+			break;
+		default:
+			q->showNormal();
+			break;
+		}
+
+		if (!tracked || reached)
+		{
+			// headless Qt applies the state at once, and a window already in
+			// it gets no notify;
+			QTimer::singleShot(0, q, [this, serial]() { finishTransition(true, serial); });
+		}
+	}
+
+	bool handleTransitionEvent(void *event)
+	{
+		Q_Q(XFramelessWidget);
+		const auto ev = static_cast<xcb_generic_event_t *>(event);
+		switch (ev->response_type & ~0x80)
+		{
+		case XCB_MAP_NOTIFY:
+			_transition.mapped = true;
+			checkTransitionState();
+			return false;
+		case XCB_PROPERTY_NOTIFY:
+		{
+			const auto notify = reinterpret_cast<xcb_property_notify_event_t *>(ev);
+			if (notify->atom == _context->atom(xutils_linux::kAtomNameSyncMarker))
+			{
+				if (_transition.confirmed)
+				{
+					// after Qt handled the events read along with this one;
+					const int serial = _transition.serial;
+					QTimer::singleShot(0, q, [this, serial]() { finishTransition(true, serial); });
+				}
+				return true;
+			}
+			// before the map it is our own pre-map write;
+			if (notify->atom == _context->atom("_NET_WM_STATE") && _transition.mapped)
+			{
+				checkTransitionState();
+			}
+			return false;
+		}
+		default:
+			return false;
+		}
+	}
+
+	void checkTransitionState()
+	{
+		Q_Q(XFramelessWidget);
+		if (!_transition.pending || _transition.confirmed)
+		{
+			return;
+		}
+
+		// a window can be minimized and maximized at once;
+		const int states = _backend->netWmStates(q);
+		const bool reached = _transition.state == XFramelessWidget::kWindowMinimized
+			? (states & xutils_linux::kNetWmStateHidden) != 0
+			: (states & QtWindowStateFlags) == _transition.state;
+		if (reached)
+		{
+			_transition.confirmed = true;
+			_backend->requestSyncNotify(q);
+		}
+	}
+
+	// ends the transition serial if it is still pending, returning its
+	// callback;
+	XFramelessWidget::StateCallback takeTransition(const int serial)
+	{
+		if (!_transition.pending || serial != _transition.serial)
+		{
+			return XFramelessWidget::StateCallback();
+		}
+
+		_transitionTimer.stop();
+		if (_transition.window)
+		{
+			_context->removeNativeEventHandler(_transition.window);
+			_transition.window = 0;
+		}
+		_transition.pending = false;
+		XFramelessWidget::StateCallback callback;
+		callback.swap(_transition.done);
+		return callback;
+	}
+
+	void finishTransition(const bool done, const int serial)
+	{
+		const XFramelessWidget::StateCallback callback = takeTransition(serial);
+		if (callback)
+		{
+			callback(done);
+		}
+	}
+
+	void doMouseMoveWork(QMouseEvent *event)
+	{
+		Q_Q(XFramelessWidget);
+		if (_fullScreen)
+		{
+			return;
+		}
+
+		if (_clientMoveResize && _clientMoveResize->isActive())
+		{
+			_clientMoveResize->update(event->globalPos());
+			return;
+		}
+
+		if (resizingCornerEdge == xutils_linux::CornerEdge::kInvalid)
+		{
+			updateCursorShape(event->x(), event->y());
+		}
+#if defined(X_FRAMELESS_QT_SYSTEM_MOVE)
+		if ((event->buttons() & Qt::LeftButton)
+			&& resizingCornerEdge == xutils_linux::CornerEdge::kInvalid
+			&& !startWmMove(event))
+		{
+			startClientMoveResize(event->globalPos(), xutils_linux::CornerEdge::kInvalid);
+		}
+#else
+		if (!useClientMoveResize())
+		{
+			startWmMove(event);
+		}
+#endif
+	}
+
+	void doMousePressWork(QMouseEvent *event)
+	{
+		Q_Q(XFramelessWidget);
+		const int x = event->x();
+		const int y = event->y();
+		if (event->button() == Qt::LeftButton && !_fullScreen)
+		{
+			const xutils_linux::CornerEdge ce = xutils_linux::GetCornerEdge(q, x, y, hitMargins(),
+				resizeHandleWidth());
+			if (ce != xutils_linux::CornerEdge::kInvalid)
+			{
+				resizingCornerEdge = ce;
+				if (!startWmResize(event, ce))
+				{
+					startClientMoveResize(event->globalPos(), ce);
+				}
+			}
+#if !defined(X_FRAMELESS_QT_SYSTEM_MOVE)
+			else if (useClientMoveResize())
+			{
+				// no WM support, move from anywhere outside the edges;
+				startClientMoveResize(event->globalPos(), ce);
+			}
+#endif
+		}
+	}
+
+	void doResizeWork(QResizeEvent *e)
+	{
+		Q_UNUSED(e);
+		updateNativeFrame();
+	}
+
+	/*!
+	 * Fullscreen windows have nothing to show in the shadow margins and 
+	 * cannot be resized, so drop both and let the compositor unredirect
+	 * the window; everything is restored once fullscreen is left.
+	 */
+	void doWindowStateChange(QEvent *e)
+	{
+		Q_UNUSED(e);
+		Q_Q(XFramelessWidget);
+		const bool fullScreen = q->isFullScreen();
+		if (fullScreen == _fullScreen)
+		{
+			updateExternalShadow();
+			return;
+		}
+
+		_fullScreen = fullScreen;
+		if (q->layout())
+		{
+			if (_fullScreen)
+			{
+				_savedMargins = q->layout()->contentsMargins();
+				q->layout()->setContentsMargins(0, 0, 0, 0);
+			}
+			else
+			{
+				q->layout()->setContentsMargins(_savedMargins);
+			}
+		}
+		if (_fullScreen)
+		{
+			updateCursorShape(-1, -1);
+		}
+		if (_backend)
+		{
+			_backend->setBypassCompositor(q, _fullScreen);
+		}
+		updateNativeFrame();
+	}
+
+	void doMouseReleaseWork(QMouseEvent *event)
+	{
+		Q_UNUSED(event);
+		if (_clientMoveResize)
+		{
+			_clientMoveResize->finish();
+		}
+		resizingCornerEdge = xutils_linux::CornerEdge::kInvalid;
+	}
+
+	/*!
+	 * Before the first map the whole set goes into _NET_WM_STATE at once, 
+	 * so the WM maps the window already in those states. Afterwards only
+	 * the difference is sent, two atoms per message with a single flush.
+	 * Minimizing is left to WM_CHANGE_STATE/WM_HINTS as EWMH asks.
+	 */
+	void doSetWindowStates(const int flags)
+	{
+		Q_Q(XFramelessWidget);
+		const Qt::WindowStates qtStates = toQtWindowStates(q, flags);
+		if (!_backend)
+		{
+			_windowStates = flags;
+			q->setWindowState(qtStates);
+			return;
+		}
+
+		const int netStates = flags & ~XFramelessWidget::kWindowMinimized;
+		if (!q->isVisible())
+		{
+			// written with the rest of the pre-map setup in doShowWork; Qt
+			// only adds its own atoms on map and makes a minimized window iconic;
+			_windowStates = flags;
+			_netWmStatePending = true;
+			q->setWindowState(qtStates);
+			return;
+		}
+
+		const int current = windowStateFlags() & ~XFramelessWidget::kWindowMinimized;
+		_backend->beginBatch();
+		_backend->changeNetWmStates(q, netStates & ~current, current & ~netStates);
+		if ((flags & XFramelessWidget::kWindowMinimized) && !q->isMinimized())
+		{
+			_backend->showMinimizedWindow(q);
+		}
+		_backend->endBatch();
+		_windowStates = flags;
+
+		if (!(flags & XFramelessWidget::kWindowMinimized) && q->isMinimized())
+		{
+			q->setWindowState(q->windowState() & ~Qt::WindowMinimized);
+		}
+	}
+
+	int windowStateFlags() const
+	{
+		Q_Q(const XFramelessWidget);
+		if (!q->isVisible())
+		{
+			return _windowStates;
+		}
+		return (_windowStates & ~QtWindowStateFlags) | fromQtWindowStates(q);
+	}
+
+	void writeNetWmState()
+	{
+		Q_Q(XFramelessWidget);
+		int property = _windowStates & ~XFramelessWidget::kWindowMinimized;
+		property |= q->windowModality() != Qt::NonModal ? xutils_linux::kNetWmStateModal : 0;
+		property |= (q->windowFlags() & Qt::WindowStaysOnBottomHint) ? xutils_linux::kNetWmStateBelow : 0;
+		_backend->setNetWmStateProperty(q, property);
+		_netWmStatePending = false;
+	}
+
+private:
+	Q_DECLARE_PUBLIC(XFramelessWidget);
+	XFramelessWidget *q_ptr;
+	XFramelessContext::Ref _context;
+	xutils_linux::CornerEdge resizingCornerEdge;
+	Qt::WindowFlags     dwindowFlags;
+
+	// null when Qt alone handles the window, e.g. on Wayland;
+	QScopedPointer<xutils_linux::Backend> _backend;
+	bool _fullScreen = false;
+	QMargins _savedMargins;
+	int _windowStates = 0;
+	bool _netWmStatePending = false;
+	WId _configuredWindow = 0;
+
+	// the one pending *Async() state change, see doShowStateAsync();
+	struct Transition
+	{
+		XFramelessWidget::StateCallback done;
+		bool pending = false;
+		int state = 0;
+		int serial = 0;
+		bool mapped = false;
+		bool confirmed = false;
+		WId window = 0;
+	};
+	Transition _transition;
+	QTimer _transitionTimer;
+
+	unsigned long _edgeWindows[xutils_linux::kEdgeWindowCount] = {};
+	WId _edgeParent = 0;
+
+	XFramelessWidget::ShadowMode _shadowMode = XFramelessWidget::kShadowInMargins;
+	int _shadowRadius = 0;
+	QColor _shadowColor;
+	// window and device pixel radius the shadow was last written for, -1
+	// to rewrite it;
+	WId _shadowWindow = 0;
+	int _shadowPublished = 0;
+
+	// setAutoVisual(), _compositing is only kept current while it is on;
+	bool _autoVisual = false;
+	bool _compositing = false;
+	// WA_TranslucentBackground was set by updateVisual(), not the application;
+	bool _translucentSet = false;
+	// bounding shape last set on _shapedWindow, empty for none;
+	QRect _boundingShape;
+	WId _shapedWindow = 0;
+
+	// -1 until the first press, then whether the WM lacks _NET_WM_MOVERESIZE;
+	int _clientMoveResizeMode = -1;
+	QScopedPointer<xutils_linux::ClientMoveResize> _clientMoveResize;
+
+	bool useClientMoveResize()
+	{
+		if (_clientMoveResizeMode < 0)
+		{
+			_clientMoveResizeMode = (!_backend || _backend->isMoveResizeSupported()) ? 0 : 1;
+		}
+		return _clientMoveResizeMode == 1;
+	}
+
+	void startClientMoveResize(const QPoint &globalPos, const xutils_linux::CornerEdge &ce)
+	{
+		Q_Q(XFramelessWidget);
+		if (!_backend)
+		{
+			return;
+		}
+		if (!_clientMoveResize)
+		{
+			_clientMoveResize.reset(new xutils_linux::ClientMoveResize(q, _backend.data()));
+		}
+		_clientMoveResize->start(globalPos, ce);
+	}
+
+	/*!
+	 * With X_FRAMELESS_QT_SYSTEM_MOVE the WM hand-off goes through
+	 * QWindow::startSystemMove/startSystemResize (Qt 5.15) and the platform
+	 * plugin's own connection, which also works on Wayland; otherwise 
+	 * _NET_WM_MOVERESIZE is sent with Xlib. Both return false when the
+	 * window manager cannot take over.
+	 */
+	bool startWmResize(QMouseEvent *event, const xutils_linux::CornerEdge &ce)
+	{
+		Q_Q(XFramelessWidget);
+#if defined(X_FRAMELESS_QT_SYSTEM_MOVE)
+		Q_UNUSED(event);
+		return q->windowHandle() 
+			&& q->windowHandle()->startSystemResize(xutils_linux::CornerEdge2QtEdges(ce));
+#else
+		if (!_backend || useClientMoveResize())
+		{
+			return false;
+		}
+		// X takes device pixels, like the edge window presses carry;
+		const QPoint rootPos = xutils_linux::ToNativePixels(q->windowHandle(), event->globalPos());
+		//send x11 move event dont send mouserrelease event
+		_backend->sendButtonRelease(q, event->pos() * q->devicePixelRatioF(), rootPos);
+		_backend->startResize(q, rootPos, ce, event->timestamp());
+		return true;
+#endif
+	}
+
+	bool startWmMove(QMouseEvent *event)
+	{
+		Q_Q(XFramelessWidget);
+#if defined(X_FRAMELESS_QT_SYSTEM_MOVE)
+		Q_UNUSED(event);
+		return q->windowHandle() && q->windowHandle()->startSystemMove();
+#else
+		if (!_backend)
+		{
+			return false;
+		}
+		_backend->startMove(q, event->button(),
+			xutils_linux::ToNativePixels(q->windowHandle(), event->globalPos()), event->timestamp());
+		return true;
+#endif
+	}
+
+	/*!
+	 * Publishes the frame extents and keeps the edge windows on the resize 
+	 * bands. The edge windows are (re)created whenever the native window
+	 * changes, as they are children of it.
+	 */
+	void updateNativeFrame()
+	{
+		Q_Q(XFramelessWidget);
+		// never create the native window early just for this, doShowWork
+		// catches up before it is mapped;
+		if (!_backend || !q->testAttribute(Qt::WA_WState_Created))
+		{
+			return;
+		}
+
+		_backend->setWindowExtents(q, frameMargins(), resizeHandleWidth());
+		updateExternalShadow();
+		updateBoundingShape();
+		if (_edgeParent != q->winId())
+		{
+			destroyEdgeWindows();
+			createEdgeWindows();
+		}
+		_backend->updateEdgeWindows(_edgeWindows, q->rect(), hitMargins(), resizeHandleWidth());
+	}
+
+	/*!
+	 * Without a compositor the margins would show whatever the ARGB
+	 * pixels become on an opaque screen, so the window is clipped to the
+	 * content and the resize border around it.
+	 */
+	void updateBoundingShape()
+	{
+		Q_Q(XFramelessWidget);
+		QRect shape;
+		if (_autoVisual && !_compositing && _shadowMode == XFramelessWidget::kShadowInMargins)
+		{
+			const int w = resizeHandleWidth();
+			shape = q->rect() - frameMargins() + QMargins(w, w, w, w);
+		}
+
+		if (_shapedWindow != q->winId())
+		{
+			// a new native window starts unshaped;
+			_shapedWindow = q->winId();
+			_boundingShape = QRect();
+		}
+		if (shape == _boundingShape)
+		{
+			return;
+		}
+		_boundingShape = shape;
+		_backend->setBoundingShape(q, shape);
+	}
+
+	void doSetAutoVisual(const bool on)
+	{
+		Q_Q(XFramelessWidget);
+		_autoVisual = on;
+		if (_autoVisual)
+		{
+			_compositing = _context->isCompositing();
+			updateVisual();
+		}
+		else if (_translucentSet && !q->testAttribute(Qt::WA_WState_Created))
+		{
+			q->setAttribute(Qt::WA_TranslucentBackground, false);
+			_translucentSet = false;
 		}
+		updateNativeFrame();
 	}
-};
-
-#elif defined(Q_OS_MACOS)
 
-class XFramelessWidgetPrivate final
-{
-public:
-	explicit XFramelessWidgetPrivate(XFramelessWidget* q)
-		:q_ptr(q)
+	bool isCompositing() const
 	{
-		qDebug() << "XFramelessWidgetPrivate()";
+		return _context->isCompositing();
 	}
 
-	~XFramelessWidgetPrivate() {
-		qDebug() << "~XFramelessWidgetPrivate()";
+	// another WM: ask again on the next press, and publish the shadow anew;
+	void onNetSupportedChanged()
+	{
+		_clientMoveResizeMode = -1;
+		if (_shadowPublished > 0)
+		{
+			_shadowPublished = -1;
+		}
+		updateExternalShadow();
 	}
 
-	void init()
+	void onCompositingChanged(const bool compositing)
 	{
 		Q_Q(XFramelessWidget);
-		xutils_macos::setupDialogTitleBar(q, true, true, true);
+		_compositing = compositing;
+		if (_autoVisual)
+		{
+			updateVisual();
+			updateNativeFrame();
+		}
+		emit q->compositingChanged(compositing);
 	}
 
-	void doShowCenter()
+	/*!
+	 * Qt picks the visual from WA_TranslucentBackground when it creates
+	 * the native window, so only a window not created yet can change it;
+	 * the shape and shadow of an existing one follow right away. A
+	 * translucent background the application asked for is kept. Only a
+	 * shadow painted in the margins needs the ARGB visual, the external
+	 * one is drawn by the compositor and leaves the backing store opaque.
+	 */
+	void updateVisual()
 	{
 		Q_Q(XFramelessWidget);
-		if (!qApp->desktop())
+		if (q->testAttribute(Qt::WA_WState_Created)
+			|| (q->testAttribute(Qt::WA_TranslucentBackground) && !_translucentSet))
 		{
 			return;
 		}
-		q->move(qApp->desktop()->availableGeometry().center() - q->rect().center());
-		q->show();
+		const bool translucent = _compositing
+			&& _shadowMode == XFramelessWidget::kShadowInMargins;
+		q->setAttribute(Qt::WA_TranslucentBackground, translucent);
+		_translucentSet = translucent;
 	}
 
-private:
-	Q_DECLARE_PUBLIC(XFramelessWidget);
-	XFramelessWidget *q_ptr;
-};
-
-#elif defined(Q_OS_LINUX)
-
-class XFramelessWidgetPrivate final
-{
-public:
-	explicit XFramelessWidgetPrivate(XFramelessWidget* q)
-		:q_ptr(q)
+	void doSetShadowMode(const XFramelessWidget::ShadowMode mode, const int radius,
+		const QColor &color)
 	{
-		qDebug() << "XFramelessWidgetPrivate()";
-	}
-
-	~XFramelessWidgetPrivate() {
-		qDebug() << "~XFramelessWidgetPrivate()";
+		_shadowMode = mode;
+		_shadowRadius = qMax(0, radius);
+		if (_shadowPublished > 0 && color != _shadowColor)
+		{
+			// same radius, other tiles;
+			_shadowPublished = -1;
+		}
+		_shadowColor = color;
+		if (_autoVisual)
+		{
+			updateVisual();
+		}
+		updateNativeFrame();
 	}
 
-	void init()
+	/*!
+	 * The external shadow is a property pointing at tiles shared by all
+	 * windows, so it is only written when it appears, goes or changes, not
+	 * on every resize. Maximized and fullscreen windows have none.
+	 */
+	void updateExternalShadow()
 	{
 		Q_Q(XFramelessWidget);
-		q->setWindowFlags(Qt::FramelessWindowHint);
-		resizingCornerEdge = xutils_linux::CornerEdge::kInvalid;
-		q->setMouseTracking(true);
+		if (!_backend || !q->testAttribute(Qt::WA_WState_Created))
+		{
+			return;
+		}
 
-		xutils_linux::SetMouseTransparent(q, true);
+		if (_shadowWindow != q->winId())
+		{
+			// a new native window starts without the property;
+			_shadowWindow = q->winId();
+			_shadowPublished = 0;
+		}
+		const bool shown = _shadowMode == XFramelessWidget::kShadowExternal
+			&& (!_autoVisual || _compositing) && !_fullScreen && !q->isMaximized();
+		const int radius = shown ? qRound(_shadowRadius * q->devicePixelRatioF()) : 0;
+		if (radius == _shadowPublished)
+		{
+			return;
+		}
+		_shadowPublished = radius;
+		_backend->setExternalShadow(q, radius, _shadowColor);
 	}
 
-	void doShowCenter()
+	void createEdgeWindows()
 	{
 		Q_Q(XFramelessWidget);
-		if (!qApp->desktop())
+		_backend->createEdgeWindows(q, _edgeWindows);
+		_edgeParent = q->winId();
+		for (int i = 0; i < xutils_linux::kEdgeWindowCount; ++i)
 		{
-			return;
+			const xutils_linux::CornerEdge ce = xutils_linux::EdgeWindowCornerEdge(i);
+			_context->setNativeEventHandler(_edgeWindows[i], [this, ce](void *event) {
+				return handleEdgeEvent(ce, event);
+			});
 		}
-		q->move(qApp->desktop()->availableGeometry().center() - q->rect().center());
-		q->show();
 	}
 
-	void doMouseMoveWork(QMouseEvent *event)
+	void destroyEdgeWindows()
 	{
-		Q_Q(XFramelessWidget);
-		const int x = event->x();
-		const int y = event->y();
-		if (resizingCornerEdge == xutils_linux::CornerEdge::kInvalid)
+		if (!_edgeParent)
+		{
+			return;
+		}
+		for (int i = 0; i < xutils_linux::kEdgeWindowCount; ++i)
 		{
-			xutils_linux::UpdateCursorShape(q, x, y, q->layout()->contentsMargins(), ResizeHandleWidth);
+			_context->removeNativeEventHandler(_edgeWindows[i]);
 		}
-		xutils_linux::MoveWindow(q, event->button());
+		_backend->destroyEdgeWindows(_edgeWindows);
+		_edgeParent = 0;
 	}
 
-	void doMousePressWork(QMouseEvent *event)
+	bool handleEdgeEvent(const xutils_linux::CornerEdge &ce, void *event)
 	{
-		Q_Q(XFramelessWidget);
-		const int x = event->x();
-		const int y = event->y();
-		if (event->button() == Qt::LeftButton)
+		const auto ev = static_cast<xcb_generic_event_t *>(event);
+		const auto button = reinterpret_cast<xcb_button_press_event_t *>(ev);
+		switch (ev->response_type & ~0x80)
 		{
-			const xutils_linux::CornerEdge ce = xutils_linux::GetCornerEdge(q, x, y, q->layout()->contentsMargins(),
-				ResizeHandleWidth);
-			if (ce != xutils_linux::CornerEdge::kInvalid)
+		case XCB_BUTTON_PRESS:
+			if (button->detail == XCB_BUTTON_INDEX_1 && !_fullScreen)
 			{
 				resizingCornerEdge = ce;
-				//send x11 move event dont send mouserrelease event
-				xutils_linux::SendButtonRelease(q, event->pos(), event->globalPos());
-				xutils_linux::StartResizing(q, QCursor::pos(), ce);
+				startEdgeResize(ce, QPoint(button->root_x, button->root_y), button->time);
+			}
+			return true;
+		case XCB_BUTTON_RELEASE:
+			if (_clientMoveResize)
+			{
+				_clientMoveResize->finish();
 			}
+			resizingCornerEdge = xutils_linux::CornerEdge::kInvalid;
+			return true;
+		default:
+			return false;
 		}
 	}
 
-	void doResizeWork(QResizeEvent *e)
+	/*!
+	 * The press was taken by an edge window, Qt never saw it; hand the 
+	 * resize to the WM with the press timestamp, or resize client side.
+	 * rootPos is in device pixels, as the WM wants it; the client side
+	 * resize follows Qt's global positions.
+	 */
+	void startEdgeResize(const xutils_linux::CornerEdge &ce, const QPoint &rootPos,
+		unsigned long timestamp)
 	{
-		Q_UNUSED(e);
 		Q_Q(XFramelessWidget);
-		xutils_linux::SetWindowExtents(q, q->layout()->contentsMargins(), ResizeHandleWidth);
+#if defined(X_FRAMELESS_QT_SYSTEM_MOVE)
+		Q_UNUSED(timestamp);
+		if (q->windowHandle()
+			&& q->windowHandle()->startSystemResize(xutils_linux::CornerEdge2QtEdges(ce)))
+		{
+			return;
+		}
+#else
+		if (!useClientMoveResize())
+		{
+			_backend->startResize(q, rootPos, ce, timestamp);
+			return;
+		}
+#endif
+		startClientMoveResize(xutils_linux::FromNativePixels(q->windowHandle(), rootPos), ce);
 	}
 
-	void doMouseReleaseWork(QMouseEvent *event)
+	void updateCursorShape(const int x, const int y)
 	{
-		Q_UNUSED(event);
-		resizingCornerEdge = xutils_linux::CornerEdge::kInvalid;
+		Q_Q(XFramelessWidget);
+		if (_edgeParent)
+		{
+			// the edge windows carry their own cursors;
+			return;
+		}
+#if defined(X_FRAMELESS_QT_SYSTEM_MOVE)
+		const xutils_linux::CornerEdge ce = xutils_linux::GetCornerEdge(q, x, y, hitMargins(), 
+			resizeHandleWidth());
+		if (ce == _cursorEdge)
+		{
+			return;
+		}
+		_cursorEdge = ce;
+		if (ce != xutils_linux::CornerEdge::kInvalid)
+		{
+			q->setCursor(xutils_linux::CornerEdge2QtCursor(ce));
+		}
+		else
+		{
+			q->unsetCursor();
+		}
+#else
+		if (_backend)
+		{
+			_backend->updateCursorShape(q, x, y, hitMargins(), resizeHandleWidth());
+		}
+#endif
 	}
 
-private:
-	Q_DECLARE_PUBLIC(XFramelessWidget);
-	XFramelessWidget *q_ptr;
-	xutils_linux::CornerEdge resizingCornerEdge;
-	Qt::WindowFlags     dwindowFlags;
+#if defined(X_FRAMELESS_QT_SYSTEM_MOVE)
+	xutils_linux::CornerEdge _cursorEdge = xutils_linux::CornerEdge::kInvalid;
+#endif
+
+	// the shadow area around the content, none when the compositor draws
+	// the shadow;
+	QMargins frameMargins() const
+	{
+		Q_Q(const XFramelessWidget);
+		if (_shadowMode == XFramelessWidget::kShadowExternal)
+		{
+			return QMargins();
+		}
+		return q->layout() ? q->layout()->contentsMargins() : QMargins();
+	}
+
+	// the resize bands lie outside these margins: in the shadow area, or
+	// along the inside of the window edge when there is none;
+	QMargins hitMargins() const
+	{
+		if (_shadowMode == XFramelessWidget::kShadowExternal)
+		{
+			const int w = resizeHandleWidth();
+			return QMargins(w, w, w, w);
+		}
+		return frameMargins();
+	}
+
+	int resizeHandleWidth() const
+	{
+		return _fullScreen ? 0 : ResizeHandleWidth;
+	}
 };
 #endif
 
@@ -681,12 +1569,164 @@ void XFramelessWidget::showNormal()
 #endif
 }
 
+/*!
+	Like showFullScreen(), and calls \a done once the window is fullscreen
+	at its final size, see showMaximizedAsync().
+*/
+void XFramelessWidget::showFullScreenAsync(const StateCallback &done, const int timeoutMs /*= 1000*/)
+{
+#if defined(Q_OS_LINUX)
+	Q_D(XFramelessWidget);
+	d->doShowStateAsync(kWindowFullScreen, done, timeoutMs);
+#else
+	Q_UNUSED(timeoutMs);
+	showFullScreen();
+	QTimer::singleShot(0, this, [done]() { if (done) { done(true); } });
+#endif
+}
+
+/*!
+	Like showMaximized(), and calls \a done once the window is maximized at
+	its final size, so content can lay out once instead of on every step.
+
+	On Linux that is when the window manager wrote the new _NET_WM_STATE and
+	the geometry it set along with it reached the widget; \a done gets false
+	if that does not happen within \a timeoutMs milliseconds, or when
+	another *Async() call comes first. It is never called once the widget
+	is destroyed. Elsewhere the state is in place when the call returns and
+	\a done runs from the event loop.
+*/
+void XFramelessWidget::showMaximizedAsync(const StateCallback &done, const int timeoutMs /*= 1000*/)
+{
+#if defined(Q_OS_LINUX)
+	Q_D(XFramelessWidget);
+	d->doShowStateAsync(kWindowMaximized, done, timeoutMs);
+#else
+	Q_UNUSED(timeoutMs);
+	showMaximized();
+	QTimer::singleShot(0, this, [done]() { if (done) { done(true); } });
+#endif
+}
+
+/*!
+	Like showMinimized(), see showMaximizedAsync().
+*/
+void XFramelessWidget::showMinimizedAsync(const StateCallback &done, const int timeoutMs /*= 1000*/)
+{
+#if defined(Q_OS_LINUX)
+	Q_D(XFramelessWidget);
+	d->doShowStateAsync(kWindowMinimized, done, timeoutMs);
+#else
+	Q_UNUSED(timeoutMs);
+	showMinimized();
+	QTimer::singleShot(0, this, [done]() { if (done) { done(true); } });
+#endif
+}
+
+/*!
+	Like showNormal(), see showMaximizedAsync().
+*/
+void XFramelessWidget::showNormalAsync(const StateCallback &done, const int timeoutMs /*= 1000*/)
+{
+#if defined(Q_OS_LINUX)
+	Q_D(XFramelessWidget);
+	d->doShowStateAsync(0, done, timeoutMs);
+#else
+	Q_UNUSED(timeoutMs);
+	showNormal();
+	QTimer::singleShot(0, this, [done]() { if (done) { done(true); } });
+#endif
+}
+
 void XFramelessWidget::showCenter()
 {
 	Q_D(XFramelessWidget);
 	d->doShowCenter();
 }
 
+/*!
+	Applies the WindowStateFlag bits in \a flags together. Called before the 
+	window is shown, the window comes up in those states right away instead 
+	of being shown normal first.
+*/
+void XFramelessWidget::setWindowStates(const int flags)
+{
+	Q_D(XFramelessWidget);
+	d->doSetWindowStates(flags);
+}
+
+int XFramelessWidget::windowStates() const
+{
+	Q_D(const XFramelessWidget);
+	return d->windowStateFlags();
+}
+
+/*!
+	Chooses where the drop shadow is drawn. With kShadowInMargins, the
+	default, the layout margins are the shadow area the application paints,
+	which needs a translucent backing store covering the shadow too.
+
+	With kShadowExternal on Linux the compositor draws a shadow of \a radius
+	pixels in \a color around the window (_KDE_NET_WM_SHADOW), so the window
+	is only as big as its content: keep the layout margins for padding and
+	leave Qt::WA_TranslucentBackground unset, the backing store can then be
+	opaque; setAutoVisual() does so for a window not created yet. The resize
+	handles move inside the window edge. Where the compositor does not
+	support it, the window has no shadow. Windows and macOS already draw
+	native shadows outside the window and ignore this.
+*/
+void XFramelessWidget::setShadowMode(const ShadowMode mode, const int radius /*= 16*/,
+	const QColor &color /*= QColor(0, 0, 0, 80)*/)
+{
+#if defined(Q_OS_LINUX)
+	Q_D(XFramelessWidget);
+	d->doSetShadowMode(mode, radius, color);
+#else
+	Q_UNUSED(mode);
+	Q_UNUSED(radius);
+	Q_UNUSED(color);
+#endif
+}
+
+/*!
+	On Linux, lets the window follow the compositing manager. While one runs
+	the window gets its shadow, and an ARGB visual
+	(Qt::WA_TranslucentBackground) when the shadow is painted in the margins;
+	without one it gets an opaque 24 bit visual, no shadow, and is shaped to
+	the content plus the resize border, so the margins need no
+	blending and show nothing. The visual is chosen when the native window
+	is created, a window that already exists keeps its own. A
+	Qt::WA_TranslucentBackground set by the application stays set. With a
+	translucent background the application paints the content background.
+
+	Windows and macOS always composite and ignore this.
+
+	\sa isCompositing(), compositingChanged()
+*/
+void XFramelessWidget::setAutoVisual(const bool on)
+{
+#if defined(Q_OS_LINUX)
+	Q_D(XFramelessWidget);
+	d->doSetAutoVisual(on);
+#else
+	Q_UNUSED(on);
+#endif
+}
+
+/*!
+	Whether a compositing manager runs. On Linux it is read from the server
+	once and then tracked, see compositingChanged().
+*/
+bool XFramelessWidget::isCompositing() const
+{
+#if defined(Q_OS_LINUX)
+	Q_D(const XFramelessWidget);
+	return d->isCompositing();
+#else
+	return true;
+#endif
+}
+
 void XFramelessWidget::setGeometry(int x, int y, int w, int h)
 {
 #if defined(Q_OS_WIN)
@@ -894,23 +1934,121 @@ void XFramelessWidget::mouseReleaseEvent(QMouseEvent *event)
 
 	QWidget::mouseReleaseEvent(event);
 }
+
+void XFramelessWidget::showEvent(QShowEvent *e)
+{
+	Q_D(XFramelessWidget);
+	d->doShowWork(e);
+
+	QWidget::showEvent(e);
+}
+
+void XFramelessWidget::changeEvent(QEvent *e)
+{
+	if (e->type() == QEvent::WindowStateChange)
+	{
+		Q_D(XFramelessWidget);
+		d->doWindowStateChange(e);
+	}
+
+	QWidget::changeEvent(e);
+}
 #endif
 
 #if defined(Q_OS_WIN) || defined(Q_OS_LINUX)
 class XFramelessWidgetWithCaptionPrivate final
 {
 public:
-	XFramelessWidgetWithCaptionPrivate(XFramelessWidgetWithCaption *q)
+	XFramelessWidgetWithCaptionPrivate(XFramelessWidgetWithCaption *q,
+		XFramelessWidgetWithCaption::CaptionMode mode)
 		: q_ptr(q)
 		, _layout(Q_NULLPTR)
 		, _capWgt(Q_NULLPTR)
+		, _captionMode(mode)
 	{
+		_captionTitle.apply = [this](const QString &title) { setCaptionTitle(title); };
+		_windowTitle.apply = [this](const QString &title) {
+			q_ptr->XFramelessWidget::setWindowTitle(title);
+		};
 	}
 
 	~XFramelessWidgetWithCaptionPrivate()
 	{
 	}
 
+	/*!
+	 * Applies the latest title at most once per interval: the first change
+	 * after a quiet interval right away, the following ones coalesced into
+	 * one update at the end of the interval, so the final title always
+	 * lands. An interval of 0 applies every change immediately.
+	 */
+	struct TitleCoalescer
+	{
+		TitleCoalescer()
+		{
+			timer.setSingleShot(true);
+			QObject::connect(&timer, &QTimer::timeout, [this]() { flush(); });
+		}
+
+		void setRate(const int perSecond)
+		{
+			interval = perSecond > 0 ? qMax(1, 1000 / perSecond) : 0;
+			if (interval == 0)
+			{
+				timer.stop();
+				flush();
+			}
+		}
+
+		void set(const QString &title)
+		{
+			pending = title;
+			dirty = true;
+			const qint64 elapsed = last.isValid() ? last.elapsed() : interval;
+			if (interval == 0 || elapsed >= interval)
+			{
+				timer.stop();
+				flush();
+			}
+			else if (!timer.isActive())
+			{
+				timer.start(interval - static_cast<int>(elapsed));
+			}
+		}
+
+		void flush()
+		{
+			if (!dirty)
+			{
+				return;
+			}
+			dirty = false;
+			last.start();
+			// the caption can be replaced or retitled through captionItf(),
+			// so what was applied last says nothing about what is shown;
+			apply(pending);
+		}
+
+		std::function<void(const QString &)> apply;
+		int interval = 0;
+		QString pending;
+		bool dirty = false;
+		QElapsedTimer last;
+		QTimer timer;
+	};
+
+	void doSetWindowTitle(const QString &title)
+	{
+		_captionTitle.set(title);
+		_windowTitle.set(title);
+	}
+
+	void doSetTitleUpdateRate(const int captionPerSecond, const int windowPerSecond)
+	{
+		_captionTitle.setRate(captionPerSecond);
+		_windowTitle.setRate(windowPerSecond);
+	}
+
 	void setCaptionTitle(const QString& title)
 	{
 		if (_capWgt)
@@ -930,21 +2068,16 @@ public:
 		_layout = new QVBoxLayout(q);
 		_layout->setContentsMargins(0, 0, 0, 0);
 		_layout->setSpacing(0);
-		_capWgt = new CaptionWidget(q);
-		QObject::connect(_capWgt, SIGNAL(moreClicked(const QPoint&, const QPoint&)), q,
-			SIGNAL(moreClicked(const QPoint&, const QPoint&)));
-		QObject::connect(_capWgt, SIGNAL(minimizeClicked()), q, SLOT(onMinimized()));
-		QObject::connect(_capWgt, SIGNAL(maximizeClicked()), q, SLOT(onMaximizeToggle()));
-		QObject::connect(_capWgt, SIGNAL(closed()), q, SLOT(onClosed()));
+		createCaption();
 
-		_layout->addWidget(_capWgt);
+		_layout->addWidget(_capWgt->widget());
 		_layout->addWidget(contentWidget);
 		contentWidget->setVisible(true);
-		_capWgt->raise();
+		_capWgt->widget()->raise();
 
 #if defined(Q_OS_WIN)
-		q->setCaptionWidget(_capWgt);
-		q->updateToolBarHeight(_capWgt->height() * q->window()->devicePixelRatio());
+		q->setCaptionWidget(_capWgt->widget());
+		q->updateToolBarHeight(_capWgt->widget()->height() * q->window()->devicePixelRatio());
 #elif defined(Q_OS_LINUX)
 #endif
 	}
@@ -955,23 +2088,48 @@ public:
 		_layout = new QVBoxLayout(q);
 		_layout->setContentsMargins(0, 0, 0, 0);
 		_layout->setSpacing(0);
-		_capWgt = new CaptionWidget(q);
-		QObject::connect(_capWgt, SIGNAL(moreClicked(const QPoint&, const QPoint&)), q, SIGNAL(moreClicked(const QPoint&, const QPoint&)));
-		QObject::connect(_capWgt, SIGNAL(minimized()), q, SLOT(onMinimized()));
-		QObject::connect(_capWgt, SIGNAL(maximizeClicked()), q, SLOT(onMaximizeClicked()));
-		QObject::connect(_capWgt, SIGNAL(closed()), q, SLOT(onClosed()));
+		createCaption();
 
-		_layout->addWidget(_capWgt);
+		_layout->addWidget(_capWgt->widget());
 		_layout->addLayout(layout);
-		_capWgt->raise();
+		_capWgt->widget()->raise();
 
 #if defined(Q_OS_WIN)
-		q->setCaptionWidget(_capWgt);
-		q->updateToolBarHeight(_capWgt->height() * q->window()->devicePixelRatio());
+		q->setCaptionWidget(_capWgt->widget());
+		q->updateToolBarHeight(_capWgt->widget()->height() * q->window()->devicePixelRatio());
 #elif defined(Q_OS_LINUX)
 #endif
 	}
 
+	/*!
+	 * Both caption classes have the same signals, so they are connected by
+	 * name whatever the mode.
+	 */
+	void createCaption()
+	{
+		Q_Q(XFramelessWidgetWithCaption);
+		QWidget *caption = Q_NULLPTR;
+		if (_captionMode == XFramelessWidgetWithCaption::kLightCaption)
+		{
+			LightCaptionWidget *light = new LightCaptionWidget(q);
+			_capWgt = light;
+			caption = light;
+		}
+		else
+		{
+			CaptionWidget *widget = new CaptionWidget(q);
+			_capWgt = widget;
+			caption = widget;
+		}
+		QObject::connect(caption, SIGNAL(moreClicked(const QPoint&, const QPoint&)), q,
+			SIGNAL(moreClicked(const QPoint&, const QPoint&)));
+		QObject::connect(caption, SIGNAL(minimizeClicked()), q, SLOT(onMinimized()));
+		QObject::connect(caption, SIGNAL(maximizeClicked()), q, SLOT(onMaximizeToggle()));
+		QObject::connect(caption, SIGNAL(closed()), q, SLOT(onClosed()));
+		QObject::connect(caption, SIGNAL(iconChanged(const QPixmap&)), q,
+			SLOT(onIconChanged(const QPixmap&)));
+	}
+
 	void doSetMainLayoutMargins(const int left, const int top, const int right,
 		const int bottom)
 	{
@@ -1028,12 +2186,17 @@ private:
 	Q_DECLARE_PUBLIC(XFramelessWidgetWithCaption);
 	XFramelessWidgetWithCaption *q_ptr;
 	QVBoxLayout *_layout;
-	CaptionWidget *_capWgt;
+	CaptionIterface *_capWgt;
+	XFramelessWidgetWithCaption::CaptionMode _captionMode;
+	// the label repaints and relayouts, the WM title is a property write
+	// the WM and taskbars react to, so each has its own rate;
+	TitleCoalescer _captionTitle;
+	TitleCoalescer _windowTitle;
 };
 
-XFramelessWidgetWithCaption::XFramelessWidgetWithCaption()
+XFramelessWidgetWithCaption::XFramelessWidgetWithCaption(CaptionMode mode /*= kCaptionWidget*/)
 	: XFramelessWidget()
-	, d_ptr(new XFramelessWidgetWithCaptionPrivate(this))
+	, d_ptr(new XFramelessWidgetWithCaptionPrivate(this, mode))
 {
 }
 
@@ -1044,8 +2207,24 @@ XFramelessWidgetWithCaption::~XFramelessWidgetWithCaption()
 void XFramelessWidgetWithCaption::setWindowTitle(const QString& title)
 {
 	Q_D(XFramelessWidgetWithCaption);
-	d->setCaptionTitle(title);
-	XFramelessWidget::setWindowTitle(title);
+	d->doSetWindowTitle(title);
+}
+
+/*!
+ * Opt-in coalescing for titles that change many times a second, e.g. live
+ * progress. The caption label and the window title are each updated at
+ * most the given number of times per second, always ending on the latest
+ * title; windowTitle() lags behind meanwhile. 0, the default, updates on
+ * every setWindowTitle.
+ *
+ * \param captionPerSecond caption label updates per second.
+ * \param windowPerSecond window (WM) title updates per second.
+ */
+void XFramelessWidgetWithCaption::setTitleUpdateRate(const int captionPerSecond,
+	const int windowPerSecond)
+{
+	Q_D(XFramelessWidgetWithCaption);
+	d->doSetTitleUpdateRate(captionPerSecond, windowPerSecond);
 }
 
 CaptionIterface *XFramelessWidgetWithCaption::captionItf()
@@ -1097,6 +2276,11 @@ void XFramelessWidgetWithCaption::onClosed()
 	d->doClose();
 }
 
+void XFramelessWidgetWithCaption::onIconChanged(const QPixmap& pixmap)
+{
+	setWindowIcon(QIcon(pixmap));
+}
+
 #if defined(Q_OS_WIN)
 bool XFramelessWidgetWithCaption::nativeEvent(const QByteArray &eventType, void *message, long *result)
 {
@@ -7,11 +7,14 @@
 #define X_FRAMELESS_WIDGET_EXPORT Q_DECL_IMPORT
 #endif
 
+#include "QtGui/QColor"
 #include "QtWidgets/QWidget"
 #include "QtWidgets/QVBoxLayout"
 
 #include "captionitf.h"
 
+#include <functional>
+
 class XFramelessWidgetPrivate;
 
 class X_FRAMELESS_WIDGET_EXPORT XFramelessWidget : public QWidget
@@ -19,6 +22,28 @@ class X_FRAMELESS_WIDGET_EXPORT XFramelessWidget : public QWidget
     Q_OBJECT
 
 public:
+	// states setWindowStates can apply together, before or after the window is shown;
+	enum WindowStateFlag
+	{
+		kWindowMaximized = 0x01,
+		kWindowFullScreen = 0x02,
+		kWindowMinimized = 0x04,
+		kWindowStaysOnTop = 0x08,
+		kWindowSkipTaskbar = 0x10,
+		kWindowSkipPager = 0x20,
+	};
+
+	// where the drop shadow goes, see setShadowMode();
+	enum ShadowMode
+	{
+		kShadowInMargins,
+		kShadowExternal,
+	};
+
+	// runs once a requested state is in place, with false when it was not
+	// within the timeout or another request replaced it;
+	typedef std::function<void(bool done)> StateCallback;
+
     explicit XFramelessWidget(Qt::WindowFlags f = Qt::WindowFlags());
     virtual ~XFramelessWidget();
 
@@ -38,9 +63,22 @@ public:
 	void showMaximized();
 	void showMinimized();
 	void showNormal();
+	void showFullScreenAsync(const StateCallback &done, const int timeoutMs = 1000);
+	void showMaximizedAsync(const StateCallback &done, const int timeoutMs = 1000);
+	void showMinimizedAsync(const StateCallback &done, const int timeoutMs = 1000);
+	void showNormalAsync(const StateCallback &done, const int timeoutMs = 1000);
 
 	// new feature functions;
 	void showCenter();
+	void setWindowStates(const int flags);
+	int windowStates() const;
+	void setShadowMode(const ShadowMode mode, const int radius = 16,
+		const QColor &color = QColor(0, 0, 0, 80));
+	void setAutoVisual(const bool on);
+	bool isCompositing() const;
+
+	// Linux only, once the compositing state has been read;
+	Q_SIGNAL void compositingChanged(bool compositing);
 
 #if defined(Q_OS_WIN)
 	void setCaptionWidget(QWidget* const capWgt);
@@ -57,10 +95,12 @@ protected:
     bool nativeEvent(const QByteArray &eventType, void *message, long *result) override;
 	void updateToolBarHeight(const int h);
 #elif defined(Q_OS_LINUX)
+	void changeEvent(QEvent *) Q_DECL_OVERRIDE;
 	void mouseMoveEvent(QMouseEvent *) Q_DECL_OVERRIDE;
 	void mousePressEvent(QMouseEvent *) Q_DECL_OVERRIDE;
 	void mouseReleaseEvent(QMouseEvent *) Q_DECL_OVERRIDE;
 	void resizeEvent(QResizeEvent *) Q_DECL_OVERRIDE;
+	void showEvent(QShowEvent *) Q_DECL_OVERRIDE;
 #endif
 
 private:
@@ -75,10 +115,19 @@ class X_FRAMELESS_WIDGET_EXPORT XFramelessWidgetWithCaption: public XFramelessWi
 	Q_OBJECT
 
 public:
-	explicit XFramelessWidgetWithCaption();
+	enum CaptionMode
+	{
+		// CaptionWidget, a layout of child widgets;
+		kCaptionWidget,
+		// LightCaptionWidget, one self-painted widget;
+		kLightCaption,
+	};
+
+	explicit XFramelessWidgetWithCaption(CaptionMode mode = kCaptionWidget);
 	virtual ~XFramelessWidgetWithCaption();
 
 	void setWindowTitle(const QString& title);
+	void setTitleUpdateRate(const int captionPerSecond, const int windowPerSecond);
 
 	CaptionIterface *captionItf();
 	void setContentWidget(QWidget* contentWidget);
@@ -92,6 +141,7 @@ public:
 	Q_SLOT void onMaximizeToggle();
 	Q_SLOT void onMinimized();
 	Q_SLOT void onClosed();
+	Q_SLOT void onIconChanged(const QPixmap& pixmap);
 
 protected:
 #if defined(Q_OS_WIN)
@@ -0,0 +1,124 @@
+#include "xmoveresize_linux.h"
+
+#include "xframelessbackend_linux.h"
+
+#include "QtGui/QScreen"
+#include "QtGui/QWindow"
+#include "QtWidgets/QWidget"
+
+namespace xutils_linux
+{
+
+ClientMoveResize::ClientMoveResize(QWidget *widget, Backend *backend)
+	: _widget(widget)
+	, _backend(backend)
+	, _edge(CornerEdge::kInvalid)
+	, _active(false)
+	, _dirty(false)
+{
+	_frameTimer.setSingleShot(true);
+	QObject::connect(&_frameTimer, &QTimer::timeout, [this]() { applyPending(); });
+}
+
+ClientMoveResize::~ClientMoveResize()
+{
+}
+
+bool ClientMoveResize::isActive() const
+{
+	return _active;
+}
+
+void ClientMoveResize::start(const QPoint &globalPos, const CornerEdge &ce)
+{
+	_edge = ce;
+	_pressPos = globalPos;
+	_startGeometry = _widget->geometry();
+	_pending = _startGeometry;
+	_dirty = false;
+	_active = true;
+	_lastApply.invalidate();
+	_widget->grabMouse();
+}
+
+void ClientMoveResize::update(const QPoint &globalPos)
+{
+	if (!_active) {
+		return;
+	}
+
+	_pending = geometryFor(globalPos);
+	_dirty = true;
+
+	// leading edge: apply right away when a frame has passed, otherwise 
+	// wait for the next frame and send only the latest geometry;
+	const int interval = frameInterval();
+	if (!_lastApply.isValid() || _lastApply.elapsed() >= interval) {
+		_frameTimer.stop();
+		applyPending();
+	} else if (!_frameTimer.isActive()) {
+		_frameTimer.start(interval - static_cast<int>(_lastApply.elapsed()));
+	}
+}
+
+void ClientMoveResize::finish()
+{
+	if (!_active) {
+		return;
+	}
+
+	_frameTimer.stop();
+	applyPending();
+	_widget->releaseMouse();
+	_active = false;
+	_edge = CornerEdge::kInvalid;
+}
+
+QRect ClientMoveResize::geometryFor(const QPoint &globalPos) const
+{
+	const QPoint delta = globalPos - _pressPos;
+	QRect r = _startGeometry;
+	if (_edge == CornerEdge::kInvalid) {
+		r.moveTopLeft(_startGeometry.topLeft() + delta);
+		return r;
+	}
+
+	const QSize minSize = _widget->minimumSize();
+	const QSize maxSize = _widget->maximumSize();
+	const unsigned int ce = static_cast<unsigned int>(_edge);
+	if (ce & static_cast<unsigned int>(CornerEdge::kLeft)) {
+		const int w = qBound(minSize.width(), _startGeometry.width() - delta.x(), maxSize.width());
+		r.setLeft(_startGeometry.right() - w + 1);
+	} else if (ce & static_cast<unsigned int>(CornerEdge::kRight)) {
+		r.setWidth(qBound(minSize.width(), _startGeometry.width() + delta.x(), maxSize.width()));
+	}
+	if (ce & static_cast<unsigned int>(CornerEdge::kTop)) {
+		const int h = qBound(minSize.height(), _startGeometry.height() - delta.y(), maxSize.height());
+		r.setTop(_startGeometry.bottom() - h + 1);
+	} else if (ce & static_cast<unsigned int>(CornerEdge::kBottom)) {
+		r.setHeight(qBound(minSize.height(), _startGeometry.height() + delta.y(), maxSize.height()));
+	}
+	return r;
+}
+
+void ClientMoveResize::applyPending()
+{
+	if (!_dirty) {
+		return;
+	}
+	_dirty = false;
+	_lastApply.start();
+	_backend->moveResizeWindowTo(_widget, _pending);
+}
+
+int ClientMoveResize::frameInterval() const
+{
+	qreal rate = 60.0;
+	const QWindow *window = _widget->windowHandle();
+	if (window && window->screen() && window->screen()->refreshRate() > 1.0) {
+		rate = window->screen()->refreshRate();
+	}
+	return qMax(1, qRound(1000.0 / rate));
+}
+
+}
@@ -0,0 +1,61 @@
+#ifndef XMOVERESIZE_LINUX_H
+#define XMOVERESIZE_LINUX_H
+
+#include "xutil_linux.h"
+
+#include "QtCore/QElapsedTimer"
+#include "QtCore/QPoint"
+#include "QtCore/QRect"
+#include "QtCore/QTimer"
+
+QT_BEGIN_NAMESPACE
+class QWidget;
+QT_END_NAMESPACE
+
+namespace xutils_linux
+{
+
+class Backend;
+
+/*!
+ * Client side move/resize for window managers that do not implement
+ * _NET_WM_MOVERESIZE. The pointer is grabbed for the duration of the 
+ * operation and the new geometry is computed from the CornerEdge, the
+ * widget's minimum/maximum size and the pointer motion. Motion is coalesced
+ * so the geometry changes at most once per display refresh.
+ */
+class ClientMoveResize final
+{
+public:
+	ClientMoveResize(QWidget *widget, Backend *backend);
+	~ClientMoveResize();
+
+	bool isActive() const;
+
+	// CornerEdge::kInvalid moves the window;
+	void start(const QPoint &globalPos, const CornerEdge &ce);
+	void update(const QPoint &globalPos);
+	void finish();
+
+private:
+	Q_DISABLE_COPY(ClientMoveResize)
+
+	QRect geometryFor(const QPoint &globalPos) const;
+	void applyPending();
+	int frameInterval() const;
+
+	QWidget *_widget;
+	Backend *_backend;
+	CornerEdge _edge;
+	bool _active;
+	bool _dirty;
+	QPoint _pressPos;
+	QRect _startGeometry;
+	QRect _pending;
+	QTimer _frameTimer;
+	QElapsedTimer _lastApply;
+};
+
+}
+
+#endif // XMOVERESIZE_LINUX_H
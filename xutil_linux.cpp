@@ -16,14 +16,23 @@
  */
 
 #include "xutil_linux.h"
+#include "xframelesscontext.h"
 
 #include "QtCore/QDebug"
 #include "QtCore/QTimer"
+#include "QtCore/QVector"
+#include "QtCore/QtMath"
+#include "QtGui/QColor"
+#include "QtGui/QImage"
+#include "QtGui/QScreen"
+#include "QtGui/QWindow"
 #include "QtWidgets/QWidget"
 #include "QtX11Extras/QX11Info"
 
 #include <X11/Xatom.h>
 #include <X11/Xlib.h>
+#include <X11/Xutil.h>
+#include <X11/extensions/Xfixes.h>
 #include <X11/extensions/shape.h>
 
 QT_BEGIN_NAMESPACE
@@ -59,6 +68,13 @@ const char kAtomNameWmStateAbove[] = "_NET_WM_STATE_ABOVE";
 const char kAtomNameWmStateStaysOnTop[] = "_NET_WM_STATE_STAYS_ON_TOP";
 const char kAtomNameWmSkipTaskbar[] = "_NET_WM_STATE_SKIP_TASKBAR";
 const char kAtomNameWmSkipPager[] = "_NET_WM_STATE_SKIP_PAGER";
+const char kAtomNameWmStateModal[] = "_NET_WM_STATE_MODAL";
+const char kAtomNameWmStateBelow[] = "_NET_WM_STATE_BELOW";
+const char kAtomNameFrameExtents[] = "_GTK_FRAME_EXTENTS";
+const char kAtomNameOpaqueRegion[] = "_NET_WM_OPAQUE_REGION";
+const char kAtomNameBypassCompositor[] = "_NET_WM_BYPASS_COMPOSITOR";
+const char kAtomNameNetSupported[] = "_NET_SUPPORTED";
+const char kAtomNameKdeNetWmShadow[] = "_KDE_NET_WM_SHADOW";
 
 struct MwmHints {
 	unsigned long flags;
@@ -124,6 +140,25 @@ static XCursorType CornerEdge2XCursor(const CornerEdge &ce)
 	}
 }
 
+static int g_batchDepth = 0;
+
+static void Flush(Display *display)
+{
+	// inside a batch the requests stay queued until EndBatch();
+	if (g_batchDepth == 0) {
+		XFlush(display);
+	}
+}
+
+static Atom InternAtom(Display *display, const char *name)
+{
+	// atoms never change for a display, so ask the server only once;
+	if (XFramelessContext *ctx = XFramelessContext::instance()) {
+		return ctx->atom(name);
+	}
+	return XInternAtom(display, name, false);
+}
+
 void ChangeWindowMaximizedState(const QWidget *widget, int wm_state)
 {
 	const auto display = QX11Info::display();
@@ -131,13 +166,9 @@ void ChangeWindowMaximizedState(const QWidget *widget, int wm_state)
 
 	XEvent xev;
 	memset(&xev, 0, sizeof(xev));
-	const Atom net_wm_state = XInternAtom(display, kAtomNameWmState, false);
-	const Atom vertical_maximized = XInternAtom(display,
-									kAtomNameMaximizedVert,
-									false);
-	const Atom horizontal_maximized = XInternAtom(display,
-									  kAtomNameMaximizedHorz,
-									  false);
+	const Atom net_wm_state = InternAtom(display, kAtomNameWmState);
+	const Atom vertical_maximized = InternAtom(display, kAtomNameMaximizedVert);
+	const Atom horizontal_maximized = InternAtom(display, kAtomNameMaximizedHorz);
 
 	xev.xclient.type = ClientMessage;
 	xev.xclient.message_type = net_wm_state;
@@ -155,12 +186,17 @@ void ChangeWindowMaximizedState(const QWidget *widget, int wm_state)
 			   false,
 			   SubstructureRedirectMask | SubstructureNotifyMask,
 			   &xev);
-	XFlush(display);
+	Flush(display);
 }
 
 CornerEdge GetCornerEdge(const QWidget *widget, int x, int y, const QMargins &margins, int border_width)
 {
-	QRect fullRect = widget->rect();
+	return GetCornerEdge(widget->rect(), x, y, margins, border_width);
+}
+
+CornerEdge GetCornerEdge(const QRect &windowRect, int x, int y, const QMargins &margins, int border_width)
+{
+	QRect fullRect = windowRect;
 	fullRect = fullRect.marginsRemoved(margins);
 	unsigned int ce = static_cast<unsigned int>(CornerEdge::kInvalid);
 	if ((y - fullRect.top() >= -border_width)
@@ -182,7 +218,14 @@ CornerEdge GetCornerEdge(const QWidget *widget, int x, int y, const QMargins &ma
 	return static_cast<CornerEdge>(ce);
 }
 
-void SendMoveResizeMessage(const QWidget *widget, Qt::MouseButton qbutton, int action)
+void SendMoveResizeMessage(const QWidget *widget, Qt::MouseButton qbutton, int action,
+						   const QPoint &rootPos, unsigned long timestamp)
+{
+	SendMoveResizeMessage(widget->winId(), qbutton, action, rootPos, timestamp);
+}
+
+void SendMoveResizeMessage(uint wid, Qt::MouseButton qbutton, int action,
+						   const QPoint &rootPos, unsigned long timestamp)
 {
 	const auto display = QX11Info::display();
 	const auto screen = QX11Info::appScreen();
@@ -193,27 +236,28 @@ void SendMoveResizeMessage(const QWidget *widget, Qt::MouseButton qbutton, int a
 
 	XEvent xev;
 	memset(&xev, 0, sizeof(xev));
-	const Atom net_move_resize = XInternAtom(display, kAtomNameMoveResize, false);
+	const Atom net_move_resize = InternAtom(display, kAtomNameMoveResize);
 	xev.xclient.type = ClientMessage;
 	xev.xclient.message_type = net_move_resize;
 	xev.xclient.display = display;
-	xev.xclient.window = widget->winId();
+	xev.xclient.window = wid;
 	xev.xclient.format = 32;
 
-	const auto global_position = QCursor::pos();
-	xev.xclient.data.l[0] = global_position.x();
-	xev.xclient.data.l[1] = global_position.y();
+	// the position and time of the triggering event: asking the server for
+	// the pointer would be a round trip, and the pointer may have moved on;
+	xev.xclient.data.l[0] = rootPos.x();
+	xev.xclient.data.l[1] = rootPos.y();
 	xev.xclient.data.l[2] = action;
 	xev.xclient.data.l[3] = xbtn;
 	xev.xclient.data.l[4] = 0;
-	XUngrabPointer(display, QX11Info::appTime());
+	XUngrabPointer(display, timestamp);
 
 	XSendEvent(display,
 			   QX11Info::appRootWindow(screen),
 			   false,
 			   SubstructureRedirectMask | SubstructureNotifyMask,
 			   &xev);
-	XFlush(display);
+	Flush(display);
 }
 
 bool IsCornerEdget(const QWidget *widget, int x, int y, const QMargins &margins, int border_width)
@@ -221,17 +265,24 @@ bool IsCornerEdget(const QWidget *widget, int x, int y, const QMargins &margins,
 	return GetCornerEdge(widget, x, y, margins, border_width) != CornerEdge::kInvalid;
 }
 
-void MoveWindow(const QWidget *widget, Qt::MouseButton qbutton)
+void MoveWindow(const QWidget *widget, Qt::MouseButton qbutton, const QPoint &rootPos,
+				unsigned long timestamp)
+{
+	MoveWindow(widget->winId(), qbutton, rootPos, timestamp);
+}
+
+void MoveWindow(uint wid, Qt::MouseButton qbutton, const QPoint &rootPos, unsigned long timestamp)
 {
-	SendMoveResizeMessage(widget, qbutton, _NET_WM_MOVERESIZE_MOVE);
+	SendMoveResizeMessage(wid, qbutton, _NET_WM_MOVERESIZE_MOVE, rootPos, timestamp);
 }
 
-void MoveResizeWindow(const QWidget *widget, Qt::MouseButton qbutton, int x, int y, const QMargins &margins, int border_width)
+void MoveResizeWindow(const QWidget *widget, Qt::MouseButton qbutton, int x, int y, const QMargins &margins, int border_width,
+					  const QPoint &rootPos, unsigned long timestamp)
 {
 	const CornerEdge ce = GetCornerEdge(widget, x, y, margins, border_width);
 	if (ce != CornerEdge::kInvalid) {
 		const int action = CornerEdge2WmGravity(ce);
-		SendMoveResizeMessage(widget, qbutton, action);
+		SendMoveResizeMessage(widget, qbutton, action, rootPos, timestamp);
 	}
 }
 
@@ -240,24 +291,30 @@ void ResetCursorShape(const QWidget *widget)
 	const auto display = QX11Info::display();
 	const WId window_id = widget->winId();
 	XUndefineCursor(display, window_id);
-	XFlush(display);
+	Flush(display);
 }
 
 bool SetCursorShape(const QWidget *widget, int cursor_id)
 {
 	const auto display = QX11Info::display();
 	const WId window_id = widget->winId();
-	const Cursor cursor = XCreateFontCursor(display, cursor_id);
+	XFramelessContext *ctx = XFramelessContext::instance();
+	const Cursor cursor = ctx ? ctx->fontCursor(cursor_id) : XCreateFontCursor(display, cursor_id);
 	if (!cursor) {
 		qWarning() << "[ui]::SetCursorShape() call XCreateFontCursor() failed";
 		return false;
 	}
 	const int result = XDefineCursor(display, window_id, cursor);
-	XFlush(display);
+	Flush(display);
 	return result == Success;
 }
 
 void SendButtonRelease(const QWidget *widget, const QPoint &pos, const QPoint &globalPos)
+{
+	SendButtonRelease(widget->effectiveWinId(), pos, globalPos);
+}
+
+void SendButtonRelease(uint wid, const QPoint &pos, const QPoint &globalPos)
 {
 	const auto display = QX11Info::display();
     //const auto screen = QX11Info::appScreen();
@@ -267,48 +324,51 @@ void SendButtonRelease(const QWidget *widget, const QPoint &pos, const QPoint &g
 
 	xevent.type = ButtonRelease;
 	xevent.xbutton.button = Button1;
-	xevent.xbutton.window = widget->effectiveWinId();
+	xevent.xbutton.window = wid;
 	xevent.xbutton.x = pos.x();
 	xevent.xbutton.y = pos.y();
 	xevent.xbutton.x_root = globalPos.x();
 	xevent.xbutton.y_root = globalPos.y();
 	xevent.xbutton.display = display;
 
-	XSendEvent(display, widget->effectiveWinId(), False, ButtonReleaseMask, &xevent);
-	XFlush(display);
+	XSendEvent(display, wid, False, ButtonReleaseMask, &xevent);
+	Flush(display);
 }
 
 void ShowFullscreenWindow(const QWidget *widget, bool is_fullscreen)
 {
-	const auto display = QX11Info::display();
-	const auto screen = QX11Info::appScreen();
+	ChangeNetWmStates(widget,
+					  is_fullscreen ? kNetWmStateFullScreen : 0,
+					  is_fullscreen ? 0 : kNetWmStateFullScreen);
+}
 
-	XEvent xev;
-	memset(&xev, 0, sizeof(xev));
-	const Atom net_wm_state = XInternAtom(display, kAtomNameWmState, false);
-	const Atom fullscreen = XInternAtom(display, kAtomNameFullscreen, false);
-	xev.xclient.type = ClientMessage;
-	xev.xclient.message_type = net_wm_state;
-	xev.xclient.display = display;
-	xev.xclient.window = widget->winId();
-	xev.xclient.format = 32;
+void SetBypassCompositor(const QWidget *widget, bool on)
+{
+	Q_ASSERT(widget);
 
-	if (is_fullscreen) {
-		xev.xclient.data.l[0] = _NET_WM_STATE_ADD;
-	} else {
-		xev.xclient.data.l[0] = _NET_WM_STATE_REMOVE;
+	const auto display = QX11Info::display();
+	const Atom bypassCompositor = InternAtom(display, kAtomNameBypassCompositor);
+	if (bypassCompositor == None) {
+		qWarning() << "Failed to create atom with name" << kAtomNameBypassCompositor;
+		return;
 	}
-	xev.xclient.data.l[1] = fullscreen;
-	xev.xclient.data.l[2] = 0;
-	xev.xclient.data.l[3] = 1;
 
-	XSendEvent(display,
-			   QX11Info::appRootWindow(screen),
-			   false,
-			   SubstructureRedirectMask | SubstructureNotifyMask,
-			   &xev
-			  );
-	XFlush(display);
+	if (on) {
+		// 1 asks the compositor to unredirect the window;
+		unsigned long value = 1;
+		XChangeProperty(display,
+						widget->winId(),
+						bypassCompositor,
+						XA_CARDINAL,
+						32,
+						PropModeReplace,
+						(unsigned char *)&value,
+						1);
+	} else {
+		// no property means no preference;
+		XDeleteProperty(display, widget->winId(), bypassCompositor);
+	}
+	Flush(display);
 }
 
 void ShowMaximizedWindow(const QWidget *widget)
@@ -323,8 +383,8 @@ void ShowMinimizedWindow(const QWidget *widget, bool minimized)
 
 	XEvent xev;
 	memset(&xev, 0, sizeof(xev));
-	const Atom net_wm_state = XInternAtom(display, kAtomNameWmState, false);
-	const Atom hidden = XInternAtom(display, kAtomNameHidden, false);
+	const Atom net_wm_state = InternAtom(display, kAtomNameWmState);
+	const Atom hidden = InternAtom(display, kAtomNameHidden);
 	xev.xclient.type = ClientMessage;
 	xev.xclient.message_type = net_wm_state;
 	xev.xclient.display = display;
@@ -348,7 +408,7 @@ void ShowMinimizedWindow(const QWidget *widget, bool minimized)
 			  );
 
 	XIconifyWindow(display, widget->winId(), screen);
-	XFlush(display);
+	Flush(display);
 }
 
 void ShowNormalWindow(const QWidget *widget)
@@ -378,70 +438,163 @@ bool UpdateCursorShape(const QWidget *widget, int x, int y, const QMargins &marg
 
 void SkipTaskbarPager(const QWidget *widget)
 {
-	Q_ASSERT(widget);
-
-	const auto display = QX11Info::display();
-	const auto screen = QX11Info::appScreen();
-
-	const auto wmStateAtom = XInternAtom(display, kAtomNameWmState, false);
-	const auto taskBarAtom = XInternAtom(display, kAtomNameWmSkipTaskbar, false);
-	const auto noPagerAtom = XInternAtom(display, kAtomNameWmSkipPager, false);
+	ChangeNetWmStates(widget, kNetWmStateSkipTaskbar | kNetWmStateSkipPager, 0);
+}
 
-	XEvent xev;
-	memset(&xev, 0, sizeof(xev));
+void SetStayOnTop(const QWidget *widget, bool on)
+{
+	ChangeNetWmStates(widget, on ? kNetWmStateAbove : 0, on ? 0 : kNetWmStateAbove);
+}
 
-	xev.xclient.type = ClientMessage;
-	xev.xclient.message_type = wmStateAtom;
-	xev.xclient.display = display;
-	xev.xclient.window = widget->winId();;
-	xev.xclient.format = 32;
+static QVector<Atom> NetWmStateAtoms(Display *display, int states)
+{
+	QVector<Atom> atoms;
+	if (states & kNetWmStateMaximized) {
+		atoms << InternAtom(display, kAtomNameMaximizedHorz)
+			  << InternAtom(display, kAtomNameMaximizedVert);
+	}
+	if (states & kNetWmStateFullScreen) {
+		atoms << InternAtom(display, kAtomNameFullscreen);
+	}
+	if (states & kNetWmStateAbove) {
+		atoms << InternAtom(display, kAtomNameWmStateAbove)
+			  << InternAtom(display, kAtomNameWmStateStaysOnTop);
+	}
+	if (states & kNetWmStateSkipTaskbar) {
+		atoms << InternAtom(display, kAtomNameWmSkipTaskbar);
+	}
+	if (states & kNetWmStateSkipPager) {
+		atoms << InternAtom(display, kAtomNameWmSkipPager);
+	}
+	if (states & kNetWmStateModal) {
+		atoms << InternAtom(display, kAtomNameWmStateModal);
+	}
+	if (states & kNetWmStateBelow) {
+		atoms << InternAtom(display, kAtomNameWmStateBelow);
+	}
+	return atoms;
+}
 
-	xev.xclient.data.l[0] = _NET_WM_STATE_ADD;
-	xev.xclient.data.l[1] = taskBarAtom;
-	xev.xclient.data.l[2] = noPagerAtom;
-	xev.xclient.data.l[3] = 1;
+int GetNetWmStates(const QWidget *widget)
+{
+	Q_ASSERT(widget);
 
-	XSendEvent(display,
-			   QX11Info::appRootWindow(screen),
-			   false,
-			   SubstructureRedirectMask | SubstructureNotifyMask,
-			   &xev);
-	XFlush(display);
+	const auto display = QX11Info::display();
+	Atom type = None;
+	int format = 0;
+	unsigned long nitems = 0;
+	unsigned long bytesAfter = 0;
+	unsigned char *data = Q_NULLPTR;
+	const int ret = XGetWindowProperty(display, widget->winId(),
+									   InternAtom(display, kAtomNameWmState),
+									   0, 64, False, XA_ATOM,
+									   &type, &format, &nitems, &bytesAfter, &data);
+
+	int states = 0;
+	if (ret == Success && type == XA_ATOM && format == 32 && data) {
+		const Atom horz = InternAtom(display, kAtomNameMaximizedHorz);
+		const Atom vert = InternAtom(display, kAtomNameMaximizedVert);
+		const Atom fullScreen = InternAtom(display, kAtomNameFullscreen);
+		const Atom hidden = InternAtom(display, kAtomNameHidden);
+		const unsigned long *atoms = reinterpret_cast<const unsigned long *>(data);
+		int maximized = 0;
+		for (unsigned long i = 0; i < nitems; ++i) {
+			if (atoms[i] == horz || atoms[i] == vert) {
+				++maximized;
+			} else if (atoms[i] == fullScreen) {
+				states |= kNetWmStateFullScreen;
+			} else if (atoms[i] == hidden) {
+				states |= kNetWmStateHidden;
+			}
+		}
+		// maximized in one direction only is not maximized;
+		if (maximized == 2) {
+			states |= kNetWmStateMaximized;
+		}
+	}
+	if (data) {
+		XFree(data);
+	}
+	return states;
 }
 
-void SetStayOnTop(const QWidget *widget, bool on)
+void RequestSyncNotify(const QWidget *widget)
 {
 	Q_ASSERT(widget);
 
 	const auto display = QX11Info::display();
-	const auto screen = QX11Info::appScreen();
+	const Atom marker = InternAtom(display, kAtomNameSyncMarker);
+	XChangeProperty(display, widget->winId(), marker, XA_CARDINAL, 32, PropModeAppend,
+					Q_NULLPTR, 0);
+	Flush(display);
+}
 
-	const auto wmStateAtom = XInternAtom(display, kAtomNameWmState, false);
-	const auto stateAboveAtom = XInternAtom(display, kAtomNameWmStateAbove, false);
-	const auto stateStaysOnTopAtom = XInternAtom(display,
-									 kAtomNameWmStateStaysOnTop,
-									 false);
+void SetNetWmStateProperty(const QWidget *widget, int states)
+{
+	Q_ASSERT(widget);
 
-	XEvent xev;
-	memset(&xev, 0, sizeof(xev));
+	// the WM reads the property when the window is mapped, so there is no
+	// state transition to watch; Qt only ever adds its own atoms to it;
+	const auto display = QX11Info::display();
+	const Atom wmState = InternAtom(display, kAtomNameWmState);
+	const QVector<Atom> atoms = NetWmStateAtoms(display, states);
+	if (atoms.isEmpty()) {
+		XDeleteProperty(display, widget->winId(), wmState);
+	} else {
+		XChangeProperty(display,
+						widget->winId(),
+						wmState,
+						XA_ATOM,
+						32,
+						PropModeReplace,
+						(unsigned char *)atoms.constData(),
+						atoms.size());
+	}
+	Flush(display);
+}
 
-	xev.xclient.type = ClientMessage;
-	xev.xclient.message_type = wmStateAtom;
-	xev.xclient.display = display;
-	xev.xclient.window = widget->winId();
-	xev.xclient.format = 32;
+void ChangeNetWmStates(const QWidget *widget, int add, int remove)
+{
+	Q_ASSERT(widget);
 
-	xev.xclient.data.l[0] = on ? _NET_WM_STATE_ADD : _NET_WM_STATE_REMOVE;
-	xev.xclient.data.l[1] = stateAboveAtom;
-	xev.xclient.data.l[2] = stateStaysOnTopAtom;
-	xev.xclient.data.l[3] = 1;
+	const auto display = QX11Info::display();
+	const auto screen = QX11Info::appScreen();
+	const Atom wmState = InternAtom(display, kAtomNameWmState);
+
+	// removals first, so leaving fullscreen for maximized never has both;
+	const QVector<Atom> removed = NetWmStateAtoms(display, remove & ~add);
+	const QVector<Atom> added = NetWmStateAtoms(display, add);
+	const struct {
+		long action;
+		const QVector<Atom> &atoms;
+	} changes[] = {
+		{ _NET_WM_STATE_REMOVE, removed },
+		{ _NET_WM_STATE_ADD, added },
+	};
 
-	XSendEvent(display,
-			   QX11Info::appRootWindow(screen),
-			   false,
-			   SubstructureRedirectMask | SubstructureNotifyMask,
-			   &xev);
-	XFlush(display);
+	for (const auto &change : changes) {
+		// a message carries one action and at most two atoms;
+		for (int i = 0; i < change.atoms.size(); i += 2) {
+			XEvent xev;
+			memset(&xev, 0, sizeof(xev));
+			xev.xclient.type = ClientMessage;
+			xev.xclient.message_type = wmState;
+			xev.xclient.display = display;
+			xev.xclient.window = widget->winId();
+			xev.xclient.format = 32;
+			xev.xclient.data.l[0] = change.action;
+			xev.xclient.data.l[1] = change.atoms[i];
+			xev.xclient.data.l[2] = i + 1 < change.atoms.size() ? change.atoms[i + 1] : 0;
+			xev.xclient.data.l[3] = 1;
+
+			XSendEvent(display,
+					   QX11Info::appRootWindow(screen),
+					   false,
+					   SubstructureRedirectMask | SubstructureNotifyMask,
+					   &xev);
+		}
+	}
+	Flush(display);
 }
 
 void SetMouseTransparent(const QWidget *widget, bool on)
@@ -476,106 +629,352 @@ void SetWindowExtents(const QWidget *widget, const QMargins &margins, const int
 
 void PropagateSizeHints(const QWidget *w)
 {
+	Q_ASSERT(w);
+
+	// WM_NORMAL_HINTS is in device pixels, and X sizes are 16 bits wide,
+	// so QWIDGETSIZE_MAX has to be clamped after scaling;
+	const qreal dpr = w->devicePixelRatioF();
+	const auto scaled = [dpr](int v) {
+		return static_cast<int>(qMin<qreal>(v * dpr, 32767));
+	};
+
 	const auto display = QX11Info::display();
 	XSizeHints *sh = XAllocSizeHints();
-	sh->flags = PPosition | PSize | PMinSize | PMaxSize | PResizeInc;
-	sh->x = w->x();
-	sh->y = w->y();
-	sh->min_width = w->minimumWidth();
-	sh->min_height = w->minimumHeight();
-	sh->base_width = w->baseSize().width();
-	sh->base_height = w->baseSize().height();
-	sh->max_width = w->maximumWidth();
-	sh->max_height = w->maximumHeight();
-	sh->width_inc =  w->sizeIncrement().width();
-	sh->height_inc = w->sizeIncrement().height();
+	// written in full, so keep what Qt puts there too: a user position and
+	// the gravity matching a frame exclusive position;
+	sh->flags = PMinSize | PMaxSize | PWinGravity;
+	if (w->testAttribute(Qt::WA_Moved)) {
+		sh->flags |= USPosition | PPosition;
+		sh->x = scaled(w->x());
+		sh->y = scaled(w->y());
+	}
+	sh->win_gravity = StaticGravity;
+	sh->min_width = scaled(w->minimumWidth());
+	sh->min_height = scaled(w->minimumHeight());
+	sh->max_width = scaled(w->maximumWidth());
+	sh->max_height = scaled(w->maximumHeight());
+	if (!w->baseSize().isNull()) {
+		sh->flags |= PBaseSize;
+		sh->base_width = scaled(w->baseSize().width());
+		sh->base_height = scaled(w->baseSize().height());
+	}
+	if (w->sizeIncrement().width() > 0 || w->sizeIncrement().height() > 0) {
+		sh->flags |= PResizeInc;
+		sh->width_inc = scaled(qMax(1, w->sizeIncrement().width()));
+		sh->height_inc = scaled(qMax(1, w->sizeIncrement().height()));
+	}
 	XSetWMNormalHints(display, w->winId(), sh);
 	XFree(sh);
+	Flush(display);
 }
 
-void DisableResize(const QWidget *w)
+void SetMotifWmHints(const QWidget *w, bool resizable)
 {
-	Display *display = QX11Info::display();
-	Atom mwmHintsProperty = XInternAtom(display, "_MOTIF_WM_HINTS", 0);
-	struct MwmHints *hints;
-	unsigned char *wm_data;
-	Atom wm_type;
-	int wm_format;
-	unsigned long wm_nitems, wm_bytes_after;
-
-	XGetWindowProperty(display,
-					   w->winId(),
-					   mwmHintsProperty,
-					   0,
-					   sizeof(MwmHints) / sizeof(long),
-					   false,
-					   AnyPropertyType,
-					   &wm_type,
-					   &wm_format,
-					   &wm_nitems,
-					   &wm_bytes_after,
-					   &wm_data);
-
-	hints = (MwmHints *) wm_data;
-
-	hints->flags |= MWM_HINTS_FUNCTIONS;
-	if (hints->functions == MWM_FUNC_ALL) {
-		hints->functions = MWM_FUNC_MOVE | MWM_FUNC_MINIMIZE | MWM_FUNC_CLOSE;
-	} else {
-		hints->functions &= ~MWM_FUNC_RESIZE;
-		hints->functions |= MWM_FUNC_CLOSE;
-	}
+	Q_ASSERT(w);
+
+	// everything is known here, so the hints are written without reading
+	// the current ones back first;
+	MwmHints hints;
+	memset(&hints, 0, sizeof(hints));
+	hints.flags = MWM_HINTS_FUNCTIONS | MWM_HINTS_DECORATIONS;
+	hints.functions = resizable
+		? MWM_FUNC_ALL
+		: MWM_FUNC_MOVE | MWM_FUNC_MINIMIZE | MWM_FUNC_CLOSE;
+	hints.decorations = 0;
 
-	if (hints->decorations == MWM_DECOR_ALL) {
-		hints->flags |= MWM_HINTS_DECORATIONS;
-		hints->decorations = (MWM_DECOR_BORDER
-							  | MWM_DECOR_TITLE
-							  | MWM_DECOR_MENU);
-	} else {
-		hints->decorations &= ~MWM_DECOR_RESIZEH;
-	}
+	const auto display = QX11Info::display();
+	const Atom mwmHintsProperty = InternAtom(display, "_MOTIF_WM_HINTS");
 	XChangeProperty(display,
 					w->winId(),
 					mwmHintsProperty,
 					mwmHintsProperty,
 					32,
 					PropModeReplace,
-					(unsigned char *)hints,
-					5);
+					(unsigned char *)&hints,
+					sizeof(MwmHints) / sizeof(long));
+	Flush(display);
+}
+
+void DisableResize(const QWidget *w)
+{
+	SetMotifWmHints(w, false);
 }
 
-void StartResizing(const QWidget *w, const QPoint &globalPoint, const CornerEdge &ce)
+void StartResizing(const QWidget *w, const QPoint &rootPos, const CornerEdge &ce,
+				   unsigned long timestamp)
+{
+	StartResizing(w->winId(), rootPos, ce, timestamp);
+}
+
+void StartResizing(uint winId, const QPoint &rootPos, const CornerEdge &ce,
+				   unsigned long timestamp)
 {
 	const auto display = QX11Info::display();
-	const auto winId = w->winId();
 	const auto screen = QX11Info::appScreen();
 
 	XEvent xev;
-	const Atom netMoveResize = XInternAtom(display, "_NET_WM_MOVERESIZE", false);
+	const Atom netMoveResize = InternAtom(display, "_NET_WM_MOVERESIZE");
 	xev.xclient.type = ClientMessage;
 	xev.xclient.message_type = netMoveResize;
 	xev.xclient.display = display;
 	xev.xclient.window = winId;
 	xev.xclient.format = 32;
 
-	xev.xclient.data.l[0] = globalPoint.x();
-	xev.xclient.data.l[1] = globalPoint.y();
+	xev.xclient.data.l[0] = rootPos.x();
+	xev.xclient.data.l[1] = rootPos.y();
 	xev.xclient.data.l[2] = CornerEdge2WmGravity(ce);
 	xev.xclient.data.l[3] = Button1;
 	xev.xclient.data.l[4] = 1;
-	XUngrabPointer(display, QX11Info::appTime());
+	// the press time, appTime() can be older than the implicit grab (presses
+	// on the edge windows never reach Qt) and the ungrab would be ignored;
+	XUngrabPointer(display, timestamp);
 
 	XSendEvent(display,
 			   QX11Info::appRootWindow(screen),
 			   false,
 			   SubstructureRedirectMask | SubstructureNotifyMask,
 			   &xev);
-	XFlush(display);
+	Flush(display);
+}
+
+bool WmSupports(const char *atomName)
+{
+	const auto display = QX11Info::display();
+	XFramelessContext *ctx = XFramelessContext::instance();
+
+	QVector<unsigned long> supported;
+	if (ctx && ctx->hasNetSupported()) {
+		supported = ctx->netSupported();
+	} else {
+		if (ctx) {
+			ctx->watchNetSupported();
+		}
+		Atom type = None;
+		int format = 0;
+		unsigned long nitems = 0;
+		unsigned long bytesAfter = 0;
+		unsigned char *data = Q_NULLPTR;
+		const int ret = XGetWindowProperty(display,
+										   QX11Info::appRootWindow(QX11Info::appScreen()),
+										   InternAtom(display, kAtomNameNetSupported),
+										   0, 4096, False, XA_ATOM,
+										   &type, &format, &nitems, &bytesAfter, &data);
+		if (ret == Success && type == XA_ATOM && format == 32 && data) {
+			const unsigned long *atoms = reinterpret_cast<const unsigned long *>(data);
+			supported.reserve(static_cast<int>(nitems));
+			for (unsigned long i = 0; i < nitems; ++i) {
+				supported.append(atoms[i]);
+			}
+		}
+		if (data) {
+			XFree(data);
+		}
+		if (ctx) {
+			ctx->setNetSupported(supported);
+		}
+	}
+
+	return supported.contains(InternAtom(display, atomName));
+}
+
+bool IsMoveResizeSupported()
+{
+	return WmSupports(kAtomNameMoveResize);
+}
+
+unsigned long SelectRootPropertyChanges()
+{
+	const auto display = QX11Info::display();
+	const Window root = QX11Info::appRootWindow(QX11Info::appScreen());
+	// the mask is per client and Qt's connection is this one, so add to
+	// what Qt selected instead of replacing it;
+	XWindowAttributes attributes;
+	if (!XGetWindowAttributes(display, root, &attributes)) {
+		return root;
+	}
+	if (!(attributes.your_event_mask & PropertyChangeMask)) {
+		XSelectInput(display, root, attributes.your_event_mask | PropertyChangeMask);
+		Flush(display);
+	}
+	return root;
+}
+
+static const CornerEdge kEdgeWindowEdges[kEdgeWindowCount] = {
+	CornerEdge::kTop,
+	CornerEdge::kRight,
+	CornerEdge::kBottom,
+	CornerEdge::kLeft,
+	CornerEdge::kTopLeft,
+	CornerEdge::kTopRight,
+	CornerEdge::kBottomRight,
+	CornerEdge::kBottomLeft,
+};
+
+CornerEdge EdgeWindowCornerEdge(int index)
+{
+	Q_ASSERT(index >= 0 && index < kEdgeWindowCount);
+	return kEdgeWindowEdges[index];
 }
 
-void CancelMoveWindow(const QWidget *widget, Qt::MouseButton qbutton)
+void CreateEdgeWindows(const QWidget *widget, unsigned long *ids)
 {
-	SendMoveResizeMessage(widget, qbutton, _NET_WM_MOVERESIZE_CANCEL);
+	Q_ASSERT(widget);
+
+	const auto display = QX11Info::display();
+	XFramelessContext *ctx = XFramelessContext::instance();
+
+	XSetWindowAttributes attrs;
+	memset(&attrs, 0, sizeof(attrs));
+	attrs.event_mask = ButtonPressMask | ButtonReleaseMask;
+	for (int i = 0; i < kEdgeWindowCount; ++i) {
+		// InputOnly: no pixels, the server only routes input and the cursor;
+		ids[i] = XCreateWindow(display,
+							   widget->winId(),
+							   0, 0, 1, 1, 0,
+							   CopyFromParent,
+							   InputOnly,
+							   (Visual *)CopyFromParent,
+							   CWEventMask,
+							   &attrs);
+		const unsigned int shape = static_cast<unsigned int>(CornerEdge2XCursor(kEdgeWindowEdges[i]));
+		const Cursor cursor = ctx ? ctx->fontCursor(shape) : XCreateFontCursor(display, shape);
+		XDefineCursor(display, ids[i], cursor);
+	}
+	Flush(display);
+}
+
+void UpdateEdgeWindows(const unsigned long *ids, const QRect &windowRect, const QMargins &margins,
+					   int resizeHandleWidth)
+{
+	const auto display = QX11Info::display();
+	if (resizeHandleWidth <= 0) {
+		for (int i = 0; i < kEdgeWindowCount; ++i) {
+			XUnmapWindow(display, ids[i]);
+		}
+		Flush(display);
+		return;
+	}
+
+	// same bands as GetCornerEdge, in kEdgeWindowEdges order;
+	const QRect content = windowRect.marginsRemoved(margins);
+	const int b = resizeHandleWidth;
+	const QRect bands[kEdgeWindowCount] = {
+		QRect(content.left(), content.top() - b, content.width(), b),
+		QRect(content.right() + 1, content.top(), b, content.height()),
+		QRect(content.left(), content.bottom() + 1, content.width(), b),
+		QRect(content.left() - b, content.top(), b, content.height()),
+		QRect(content.left() - b, content.top() - b, b, b),
+		QRect(content.right() + 1, content.top() - b, b, b),
+		QRect(content.right() + 1, content.bottom() + 1, b, b),
+		QRect(content.left() - b, content.bottom() + 1, b, b),
+	};
+	for (int i = 0; i < kEdgeWindowCount; ++i) {
+		XMoveResizeWindow(display,
+						  ids[i],
+						  bands[i].x(),
+						  bands[i].y(),
+						  static_cast<unsigned int>(qMax(1, bands[i].width())),
+						  static_cast<unsigned int>(qMax(1, bands[i].height())));
+		XMapRaised(display, ids[i]);
+	}
+	Flush(display);
+}
+
+void DestroyEdgeWindows(unsigned long *ids)
+{
+	const auto display = QX11Info::display();
+	if (!display) {
+		return;
+	}
+	for (int i = 0; i < kEdgeWindowCount; ++i) {
+		if (ids[i]) {
+			XDestroyWindow(display, ids[i]);
+			ids[i] = 0;
+		}
+	}
+	Flush(display);
+}
+
+bool IsPlatformX11()
+{
+	return QX11Info::isPlatformX11();
+}
+
+QPoint ToNativePixels(const QWindow *window, const QPoint &globalPos)
+{
+	const QScreen *screen = window ? window->screen() : Q_NULLPTR;
+	if (!screen) {
+		return globalPos;
+	}
+	const QPoint origin = screen->geometry().topLeft();
+	return origin + (globalPos - origin) * window->devicePixelRatio();
+}
+
+QPoint FromNativePixels(const QWindow *window, const QPoint &rootPos)
+{
+	const QScreen *screen = window ? window->screen() : Q_NULLPTR;
+	if (!screen) {
+		return rootPos;
+	}
+	const QPoint origin = screen->geometry().topLeft();
+	return origin + (rootPos - origin) / window->devicePixelRatio();
+}
+
+Qt::Edges CornerEdge2QtEdges(const CornerEdge &ce)
+{
+	const unsigned int bits = static_cast<unsigned int>(ce);
+	Qt::Edges edges;
+	if (bits & static_cast<unsigned int>(CornerEdge::kTop)) {
+		edges |= Qt::TopEdge;
+	}
+	if (bits & static_cast<unsigned int>(CornerEdge::kRight)) {
+		edges |= Qt::RightEdge;
+	}
+	if (bits & static_cast<unsigned int>(CornerEdge::kBottom)) {
+		edges |= Qt::BottomEdge;
+	}
+	if (bits & static_cast<unsigned int>(CornerEdge::kLeft)) {
+		edges |= Qt::LeftEdge;
+	}
+	return edges;
+}
+
+Qt::CursorShape CornerEdge2QtCursor(const CornerEdge &ce)
+{
+	switch (ce) {
+	case CornerEdge::kTop:
+	case CornerEdge::kBottom:      return Qt::SizeVerCursor;
+	case CornerEdge::kLeft:
+	case CornerEdge::kRight:       return Qt::SizeHorCursor;
+	case CornerEdge::kTopLeft:
+	case CornerEdge::kBottomRight: return Qt::SizeFDiagCursor;
+	case CornerEdge::kTopRight:
+	case CornerEdge::kBottomLeft:  return Qt::SizeBDiagCursor;
+	default:                       return Qt::ArrowCursor;
+	}
+}
+
+void BeginBatch()
+{
+	++g_batchDepth;
+}
+
+void EndBatch()
+{
+	Q_ASSERT(g_batchDepth > 0);
+	if (--g_batchDepth > 0) {
+		return;
+	}
+	// no X connection on Wayland or offscreen, nothing was queued;
+	Display *display = QX11Info::display();
+	if (display) {
+		XFlush(display);
+	}
+}
+
+void CancelMoveWindow(const QWidget *widget, Qt::MouseButton qbutton, unsigned long timestamp)
+{
+	SendMoveResizeMessage(widget, qbutton, _NET_WM_MOVERESIZE_CANCEL, QPoint(), timestamp);
 }
 
 void SetWindowExtents(uint wid, const QRect &windowRect, const QMargins &margins, const int resizeHandleSize)
@@ -587,9 +986,9 @@ void SetWindowExtents(uint wid, const QRect &windowRect, const QMargins &margins
 		(unsigned long)(margins.top()),
 		(unsigned long)(margins.bottom())
 	};
-	frameExtents = XInternAtom(QX11Info::display(), "_GTK_FRAME_EXTENTS", False);
+	frameExtents = InternAtom(QX11Info::display(), kAtomNameFrameExtents);
 	if (frameExtents == None) {
-		qWarning() << "Failed to create atom with name DEEPIN_WINDOW_SHADOW";
+		qWarning() << "Failed to create atom with name" << kAtomNameFrameExtents;
 		return;
 	}
 	XChangeProperty(QX11Info::display(),
@@ -605,6 +1004,10 @@ void SetWindowExtents(uint wid, const QRect &windowRect, const QMargins &margins
 
 	tmp_rect -= margins;
 
+	// The area inside the extents is the content, everything else is
+	// shadow; let the compositor skip blending the content.
+	SetOpaqueRegion(wid, tmp_rect);
+
 	XRectangle contentXRect;
 	contentXRect.x = 0;
 	contentXRect.y = 0;
@@ -618,6 +1021,200 @@ void SetWindowExtents(uint wid, const QRect &windowRect, const QMargins &margins
 							&contentXRect, 1, ShapeSet, YXBanded);
 }
 
+void SetBoundingShape(uint wid, const QRect &shapeRect)
+{
+	const auto display = QX11Info::display();
+	if (shapeRect.isEmpty()) {
+		// back to the unshaped window;
+		XShapeCombineMask(display, wid, ShapeBounding, 0, 0, None, ShapeSet);
+	} else {
+		XRectangle xrect;
+		xrect.x = 0;
+		xrect.y = 0;
+		xrect.width = shapeRect.width();
+		xrect.height = shapeRect.height();
+		XShapeCombineRectangles(display,
+								wid,
+								ShapeBounding,
+								shapeRect.x(),
+								shapeRect.y(),
+								&xrect, 1, ShapeSet, YXBanded);
+	}
+	Flush(display);
+}
+
+bool WatchCompositingManager(unsigned long *selection, int *notifyEventType)
+{
+	const auto display = QX11Info::display();
+	const int screen = QX11Info::appScreen();
+	const QByteArray name = QByteArray("_NET_WM_CM_S") + QByteArray::number(screen);
+	*selection = InternAtom(display, name.constData());
+	*notifyEventType = -1;
+
+	int eventBase = 0;
+	int errorBase = 0;
+	if (XFixesQueryExtension(display, &eventBase, &errorBase)) {
+		// a compositor going away by crashing only shows as its client
+		// closing or its window being destroyed;
+		XFixesSelectSelectionInput(display,
+								   QX11Info::appRootWindow(screen),
+								   *selection,
+								   XFixesSetSelectionOwnerNotifyMask
+								   | XFixesSelectionWindowDestroyNotifyMask
+								   | XFixesSelectionClientCloseNotifyMask);
+		*notifyEventType = eventBase + XFixesSelectionNotify;
+	} else {
+		qWarning() << "XFixes is missing, compositing manager changes are not tracked";
+	}
+
+	// read after selecting the input, so no change can fall in between;
+	return XGetSelectionOwner(display, *selection) != None;
+}
+
+void SetOpaqueRegion(uint wid, const QRect &opaqueRect)
+{
+	const auto display = QX11Info::display();
+	const Atom opaqueRegion = InternAtom(display, kAtomNameOpaqueRegion);
+	if (opaqueRegion == None) {
+		qWarning() << "Failed to create atom with name" << kAtomNameOpaqueRegion;
+		return;
+	}
+
+	if (opaqueRect.isEmpty()) {
+		XDeleteProperty(display, wid, opaqueRegion);
+		return;
+	}
+
+	unsigned long value[4] = {
+		(unsigned long)(opaqueRect.x()),
+		(unsigned long)(opaqueRect.y()),
+		(unsigned long)(opaqueRect.width()),
+		(unsigned long)(opaqueRect.height())
+	};
+	XChangeProperty(display,
+					wid,
+					opaqueRegion,
+					XA_CARDINAL,
+					32,
+					PropModeReplace,
+					(unsigned char *)value,
+					4);
+}
+
+// direction each tile falls off in, in _KDE_NET_WM_SHADOW order;
+static const int kShadowTileSides[kShadowTileCount][2] = {
+	{ 0, -1 }, { 1, -1 }, { 1, 0 }, { 1, 1 }, { 0, 1 }, { -1, 1 }, { -1, 0 }, { -1, -1 },
+};
+
+static QImage ShadowTileImage(int index, int radius, const QColor &color)
+{
+	const int sx = kShadowTileSides[index][0];
+	const int sy = kShadowTileSides[index][1];
+	QImage image(sx ? radius : 1, sy ? radius : 1, QImage::Format_ARGB32_Premultiplied);
+
+	for (int y = 0; y < image.height(); ++y) {
+		QRgb *line = reinterpret_cast<QRgb *>(image.scanLine(y));
+		for (int x = 0; x < image.width(); ++x) {
+			// distance from the window edge, measured from pixel centres;
+			const qreal dx = sx < 0 ? radius - x - 0.5 : (sx > 0 ? x + 0.5 : 0);
+			const qreal dy = sy < 0 ? radius - y - 0.5 : (sy > 0 ? y + 0.5 : 0);
+			const qreal t = qMax<qreal>(0, 1 - qSqrt(dx * dx + dy * dy) / radius);
+			const int alpha = qRound(color.alpha() * t * t);
+			line[x] = qPremultiply(qRgba(color.red(), color.green(), color.blue(), alpha));
+		}
+	}
+	return image;
+}
+
+bool CreateShadowTiles(int radius, const QColor &color, unsigned long *tiles)
+{
+	const auto display = QX11Info::display();
+	const int screen = QX11Info::appScreen();
+
+	// the compositor blends the tiles with their alpha, which needs a 32
+	// bit visual, as for any ARGB window;
+	XVisualInfo visualInfo;
+	if (radius <= 0 || !XMatchVisualInfo(display, screen, 32, TrueColor, &visualInfo)) {
+		return false;
+	}
+
+	const Window root = QX11Info::appRootWindow(screen);
+	for (int i = 0; i < kShadowTileCount; ++i) {
+		QImage image = ShadowTileImage(i, radius, color);
+		const Pixmap pixmap = XCreatePixmap(display, root, image.width(), image.height(), 32);
+		const GC gc = XCreateGC(display, pixmap, 0, Q_NULLPTR);
+		XImage *ximage = XCreateImage(display, visualInfo.visual, 32, ZPixmap, 0,
+									  reinterpret_cast<char *>(image.bits()),
+									  image.width(), image.height(), 32, image.bytesPerLine());
+		// the pixels are in client byte order, Xlib swaps them if needed;
+		ximage->byte_order = Q_BYTE_ORDER == Q_LITTLE_ENDIAN ? LSBFirst : MSBFirst;
+		XPutImage(display, pixmap, gc, ximage, 0, 0, 0, 0, image.width(), image.height());
+		// the data belongs to the QImage;
+		ximage->data = Q_NULLPTR;
+		XDestroyImage(ximage);
+		XFreeGC(display, gc);
+		tiles[i] = pixmap;
+	}
+	Flush(display);
+	return true;
+}
+
+void FreeShadowTiles(const unsigned long *tiles)
+{
+	const auto display = QX11Info::display();
+	for (int i = 0; i < kShadowTileCount; ++i) {
+		XFreePixmap(display, tiles[i]);
+	}
+}
+
+bool IsExternalShadowSupported()
+{
+	return WmSupports(kAtomNameKdeNetWmShadow);
+}
+
+void SetExternalShadow(const QWidget *widget, const unsigned long *tiles, int radius)
+{
+	Q_ASSERT(widget);
+
+	const auto display = QX11Info::display();
+	const Atom shadow = InternAtom(display, kAtomNameKdeNetWmShadow);
+	if (shadow == None) {
+		qWarning() << "Failed to create atom with name" << kAtomNameKdeNetWmShadow;
+		return;
+	}
+
+	// eight tiles, then how far the shadow reaches past the top, right,
+	// bottom and left edges;
+	unsigned long value[kShadowTileCount + 4];
+	for (int i = 0; i < kShadowTileCount; ++i) {
+		value[i] = tiles[i];
+	}
+	for (int i = kShadowTileCount; i < kShadowTileCount + 4; ++i) {
+		value[i] = static_cast<unsigned long>(radius);
+	}
+	XChangeProperty(display,
+					widget->winId(),
+					shadow,
+					XA_CARDINAL,
+					32,
+					PropModeReplace,
+					(unsigned char *)value,
+					kShadowTileCount + 4);
+	Flush(display);
+}
+
+void RemoveExternalShadow(const QWidget *widget)
+{
+	Q_ASSERT(widget);
+
+	const auto display = QX11Info::display();
+	const Atom shadow = InternAtom(display, kAtomNameKdeNetWmShadow);
+	if (shadow != None) {
+		XDeleteProperty(display, widget->winId(), shadow);
+		Flush(display);
+	}
+}
+
 }
 
 QT_END_NAMESPACE
@@ -22,9 +22,11 @@
 
 QT_BEGIN_NAMESPACE
 class QWidget;
+class QColor;
 class QPoint;
 class QMargins;
 class QRect;
+class QWindow;
 
 namespace xutils_linux
 {
@@ -56,34 +58,123 @@ enum class XCursorType
 	kTopLeft = 134,
 };
 
+// _NET_WM_STATE sets, the bits follow XFramelessWidget::WindowStateFlag;
+enum NetWmState
+{
+	kNetWmStateMaximized = 0x01,	// _NET_WM_STATE_MAXIMIZED_HORZ and _VERT
+	kNetWmStateFullScreen = 0x02,
+	kNetWmStateHidden = 0x04,		// read only, the WM sets it on minimizing
+	kNetWmStateAbove = 0x08,		// _NET_WM_STATE_ABOVE and _STAYS_ON_TOP
+	kNetWmStateSkipTaskbar = 0x10,
+	kNetWmStateSkipPager = 0x20,
+	kNetWmStateModal = 0x40,
+	kNetWmStateBelow = 0x80,
+};
+
 void SendButtonRelease(const QWidget *widget,
 									 const QPoint &pos, const QPoint &globalPos);
+void SendButtonRelease(uint wid, const QPoint &pos, const QPoint &globalPos);
 
 void ChangeWindowMaximizedState(const QWidget *widget, int wm_state);
 CornerEdge GetCornerEdge(const QWidget *widget, int x, int y, const QMargins &margins, int border_width);
+CornerEdge GetCornerEdge(const QRect &windowRect, int x, int y, const QMargins &margins, int border_width);
 bool UpdateCursorShape(const QWidget *widget, int x, int y, const QMargins &margins, int border_width);
 bool IsCornerEdget(const QWidget *widget, int x, int y, const QMargins &margins, int border_width);
-void MoveResizeWindow(const QWidget *widget, Qt::MouseButton qbutton, int x, int y, const QMargins &margins, int border_width);
+void MoveResizeWindow(const QWidget *widget, Qt::MouseButton qbutton, int x, int y, const QMargins &margins, int border_width,
+					  const QPoint &rootPos, unsigned long timestamp);
 
-void StartResizing(const QWidget *w, const QPoint &globalPoint, const CornerEdge &ce);
-void SendMoveResizeMessage(const QWidget *widget, Qt::MouseButton qbutton, int action);
-void MoveWindow(const QWidget *widget, Qt::MouseButton qbutton);
-void CancelMoveWindow(const QWidget *widget, Qt::MouseButton qbutton);
+// _NET_WM_MOVERESIZE hand-off. rootPos and timestamp come from the event
+// that starts the operation, so no call waits on the server. The window
+// id overloads serve windows that are not widgets, e.g. a QQuickWindow;
+void StartResizing(const QWidget *w, const QPoint &rootPos, const CornerEdge &ce,
+				   unsigned long timestamp);
+void StartResizing(uint winId, const QPoint &rootPos, const CornerEdge &ce,
+				   unsigned long timestamp);
+void SendMoveResizeMessage(const QWidget *widget, Qt::MouseButton qbutton, int action,
+						   const QPoint &rootPos, unsigned long timestamp);
+void SendMoveResizeMessage(uint wid, Qt::MouseButton qbutton, int action,
+						   const QPoint &rootPos, unsigned long timestamp);
+void MoveWindow(const QWidget *widget, Qt::MouseButton qbutton, const QPoint &rootPos,
+				unsigned long timestamp);
+void MoveWindow(uint wid, Qt::MouseButton qbutton, const QPoint &rootPos, unsigned long timestamp);
+void CancelMoveWindow(const QWidget *widget, Qt::MouseButton qbutton, unsigned long timestamp);
 
 void ResetCursorShape(const QWidget *widget);
 bool SetCursorShape(const QWidget *widget, int cursor_id);
 void ShowFullscreenWindow(const QWidget *widget, bool is_fullscreen);
+void SetBypassCompositor(const QWidget *widget, bool on);
 void ShowMaximizedWindow(const QWidget *widget);
 void ShowMinimizedWindow(const QWidget *widget, bool minimized);
 void ShowNormalWindow(const QWidget *widget);
 void ToggleMaximizedWindow(const QWidget *widget);
 void SkipTaskbarPager(const QWidget *widget);
 void SetStayOnTop(const QWidget *widget, bool on);
+// before map: writes the whole _NET_WM_STATE property in one request;
+void SetNetWmStateProperty(const QWidget *widget, int states);
+// after map: as few _NET_WM_STATE messages as possible, flushed once;
+void ChangeNetWmStates(const QWidget *widget, int add, int remove);
+// kNetWmStateMaximized, kNetWmStateFullScreen and kNetWmStateHidden as the
+// WM last wrote them, a round trip;
+int GetNetWmStates(const QWidget *widget);
+
+// A zero length append to this property makes the server send a
+// PropertyNotify after every event caused before the request, without
+// the client waiting for it;
+constexpr char kAtomNameSyncMarker[] = "_XFRAMELESS_SYNC";
+void RequestSyncNotify(const QWidget *widget);
 void SetMouseTransparent(const QWidget *widget, bool on);
 void SetWindowExtents(const QWidget *widget, const QMargins &margins, const int resizeHandlSize);
 void SetWindowExtents(uint wid, const QRect &windowRect, const QMargins &margins, const int resizeHandleSize);
+void SetOpaqueRegion(uint wid, const QRect &opaqueRect);
+// an empty rect removes the bounding shape;
+void SetBoundingShape(uint wid, const QRect &shapeRect);
+
+// Whether a compositing manager owns _NET_WM_CM_S<screen>. Also asks for
+// XFixes selection owner notifications of it: selection is set to the
+// atom and notifyEventType to the event type they arrive as, -1 when
+// XFixes is missing;
+bool WatchCompositingManager(unsigned long *selection, int *notifyEventType);
 void PropagateSizeHints(const QWidget *w);
 void DisableResize(const QWidget *w);
+void SetMotifWmHints(const QWidget *w, bool resizable);
+
+// InputOnly child windows over the eight resize bands, each with its own
+// cursor, so hovering the border needs no client work at all;
+constexpr int kEdgeWindowCount = 8;
+CornerEdge EdgeWindowCornerEdge(int index);
+void CreateEdgeWindows(const QWidget *widget, unsigned long *ids);
+void UpdateEdgeWindows(const unsigned long *ids, const QRect &windowRect, const QMargins &margins,
+					   int resizeHandleWidth);
+void DestroyEdgeWindows(unsigned long *ids);
+
+// Shadow drawn by the compositor outside the window, from the eight tiles
+// of _KDE_NET_WM_SHADOW (top, top-right, right, ... , top-left), so the
+// window itself needs no transparent margins. The tiles are pixmaps on the
+// server that windows with the same shadow can share;
+constexpr int kShadowTileCount = 8;
+bool CreateShadowTiles(int radius, const QColor &color, unsigned long *tiles);
+void FreeShadowTiles(const unsigned long *tiles);
+bool IsExternalShadowSupported();
+void SetExternalShadow(const QWidget *widget, const unsigned long *tiles, int radius);
+void RemoveExternalShadow(const QWidget *widget);
+
+bool IsPlatformX11();
+// X root positions are device pixels, Qt's global positions are not; the
+// screen of window keeps its top left corner in both;
+QPoint ToNativePixels(const QWindow *window, const QPoint &globalPos);
+QPoint FromNativePixels(const QWindow *window, const QPoint &rootPos);
+Qt::Edges CornerEdge2QtEdges(const CornerEdge &ce);
+Qt::CursorShape CornerEdge2QtCursor(const CornerEdge &ce);
+
+bool WmSupports(const char *atomName);
+bool IsMoveResizeSupported();
+// PropertyNotify on the root window, e.g. for _NET_SUPPORTED; returns the root;
+unsigned long SelectRootPropertyChanges();
+
+// Requests issued between BeginBatch() and EndBatch() are flushed once, at
+// the outermost EndBatch();
+void BeginBatch();
+void EndBatch();
 
 }
 #endif // !XUTILS_LINUX_H